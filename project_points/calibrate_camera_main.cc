@@ -0,0 +1,132 @@
+// Calibrates the camera intrinsics from a directory of board images.
+// bazel run -c opt //project_points:calibrate_camera_main --
+// --image_dir=/tmp/calibration --pattern=charuco --board_width=8
+// --board_height=6 --square_size=25 --marker_size=18
+// --output_path=/tmp/calibration.txtpb
+#include <algorithm>
+#include <filesystem>
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/status/status.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "opencv2/core.hpp"
+#include "project_points/camera_calibration.h"
+#include "project_points/proto_utils.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, image_dir, "", "Directory of calibration images");
+
+ABSL_FLAG(std::string, pattern, "chessboard", "chessboard or charuco");
+
+ABSL_FLAG(int32_t, board_width, 9,
+          "Inner corners per row for a chessboard, squares for ChArUco");
+
+ABSL_FLAG(int32_t, board_height, 6,
+          "Inner corners per column for a chessboard, squares for ChArUco");
+
+ABSL_FLAG(double, square_size, 25, "Square side, e.g. in mm");
+
+ABSL_FLAG(double, marker_size, 18,
+          "ChArUco marker side, same unit as square_size");
+
+ABSL_FLAG(double, max_view_error_px, 1.0,
+          "Views with a larger RMS reprojection error are dropped");
+
+ABSL_FLAG(int32_t, threads, 0,
+          "Corner detection threads, 0 for OpenCV's default");
+
+ABSL_FLAG(std::string, output_path, "calibration.txtpb",
+          "Output IntrinsicCalibration text proto");
+
+absl::StatusOr<std::vector<std::string>> ListImages(absl::string_view dir) {
+  std::error_code error;
+  std::filesystem::directory_iterator it(std::string(dir), error);
+  if (error) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Failed to list ", dir, ": ", error.message()));
+  }
+  std::vector<std::string> paths;
+  for (const std::filesystem::directory_entry& entry : it) {
+    const std::string extension =
+        absl::AsciiStrToLower(entry.path().extension().string());
+    if (entry.is_regular_file() &&
+        (extension == ".jpg" || extension == ".jpeg" || extension == ".png")) {
+      paths.push_back(entry.path().string());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+absl::Status Run() {
+  aruco::CalibrationOptions options;
+  const std::string pattern = absl::GetFlag(FLAGS_pattern);
+  if (pattern == "charuco") {
+    options.pattern = aruco::CalibrationPattern::kCharuco;
+  } else if (pattern != "chessboard") {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unknown pattern '", pattern, "'"));
+  }
+  options.board_size = cv::Size(absl::GetFlag(FLAGS_board_width),
+                                absl::GetFlag(FLAGS_board_height));
+  options.square_size = absl::GetFlag(FLAGS_square_size);
+  options.marker_size = absl::GetFlag(FLAGS_marker_size);
+  options.max_view_error_px = absl::GetFlag(FLAGS_max_view_error_px);
+  if (absl::GetFlag(FLAGS_threads) > 0) {
+    cv::setNumThreads(absl::GetFlag(FLAGS_threads));
+  }
+
+  ASSIGN_OR_RETURN(const std::vector<std::string> paths,
+                   ListImages(absl::GetFlag(FLAGS_image_dir)));
+  const aruco::CornerDetection detection =
+      aruco::DetectCalibrationCorners(paths, options);
+  LOG(INFO) << absl::StreamFormat(
+      "Detected the board in %d of %d images in %.2f s on %d threads, %.1f "
+      "images/s, %.1f MPix/s",
+      detection.views.size(), detection.images, detection.seconds,
+      cv::getNumThreads(), detection.images / detection.seconds,
+      detection.megapixels / detection.seconds);
+  for (const std::string& path : detection.failed_paths) {
+    LOG(WARNING) << "No board in " << path;
+  }
+
+  ASSIGN_OR_RETURN(const aruco::CalibrationResult result,
+                   aruco::CalibrateCamera(detection.views, options));
+  for (int32_t i : result.rejected_views) {
+    LOG(WARNING) << "Rejected outlier " << detection.views[i].image_path;
+  }
+  for (size_t i = 0; i < result.used_views.size(); ++i) {
+    VLOG(1) << absl::StreamFormat(
+        "%s: %.3f px", detection.views[result.used_views[i]].image_path,
+        result.view_errors[i]);
+  }
+  LOG(INFO) << absl::StreamFormat("Calibrated from %d views, RMS %.3f px",
+                                  result.used_views.size(),
+                                  result.reprojection_error);
+  LOG(INFO) << "Camera matrix " << result.calibration.camera_matrix;
+  LOG(INFO) << "Distortion " << result.calibration.distortion_params;
+
+  aruco::proto::IntrinsicCalibration proto =
+      aruco::ConvertIntrinsicCalibrationToProto(result.calibration);
+  proto.set_reprojection_error(result.reprojection_error);
+  RETURN_IF_ERROR(
+      aruco::WriteProtoToTextProto(proto, absl::GetFlag(FLAGS_output_path))
+          .status());
+  LOG(INFO) << "Calibration: " << absl::GetFlag(FLAGS_output_path);
+  return absl::OkStatus();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  gflags::SetCommandLineOption("logtostderr", "1");
+  if (const auto status = Run(); !status.ok()) {
+    LOG(ERROR) << "Failed: " << status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+#include "project_points/camera_calibration.h"
+#include <algorithm>
+#include <optional>
+#include "absl/strings/str_cat.h"
+#include "opencv2/calib3d.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/objdetect/charuco_detector.hpp"
+
+namespace aruco {
+namespace {
+
+std::optional<ViewCorners> DetectChessboard(const cv::Mat& gray,
+                                            const CalibrationOptions& options) {
+  std::vector<cv::Point2f> corners;
+  // The sector based detector is sub-pixel accurate without cornerSubPix.
+  if (!cv::findChessboardCornersSB(gray, options.board_size, corners,
+                                   cv::CALIB_CB_NORMALIZE_IMAGE |
+                                       cv::CALIB_CB_EXHAUSTIVE)) {
+    return std::nullopt;
+  }
+  ViewCorners view;
+  for (int32_t y = 0; y < options.board_size.height; ++y) {
+    for (int32_t x = 0; x < options.board_size.width; ++x) {
+      view.object_points.emplace_back(x * options.square_size,
+                                      y * options.square_size, 0);
+    }
+  }
+  view.image_points = std::move(corners);
+  return view;
+}
+
+std::optional<ViewCorners> DetectCharuco(const cv::Mat& gray,
+                                         const cv::aruco::CharucoBoard& board,
+                                         const CalibrationOptions& options) {
+  const cv::aruco::CharucoDetector detector(board);
+  std::vector<cv::Point2f> charuco_corners;
+  std::vector<int32_t> charuco_ids;
+  detector.detectBoard(gray, charuco_corners, charuco_ids);
+  if (static_cast<int32_t>(charuco_ids.size()) < options.min_charuco_corners) {
+    return std::nullopt;
+  }
+  ViewCorners view;
+  board.matchImagePoints(charuco_corners, charuco_ids, view.object_points,
+                         view.image_points);
+  return view;
+}
+
+double Median(std::vector<double> values) {
+  std::nth_element(values.begin(), values.begin() + values.size() / 2,
+                   values.end());
+  return values[values.size() / 2];
+}
+
+}  // namespace
+
+CornerDetection DetectCalibrationCorners(
+    const std::vector<std::string>& image_paths,
+    const CalibrationOptions& options) {
+  std::optional<cv::aruco::CharucoBoard> board;
+  if (options.pattern == CalibrationPattern::kCharuco) {
+    board.emplace(options.board_size, options.square_size, options.marker_size,
+                  cv::aruco::getPredefinedDictionary(options.dictionary));
+  }
+
+  const int32_t count = static_cast<int32_t>(image_paths.size());
+  std::vector<std::optional<ViewCorners>> views(count);
+  std::vector<double> megapixels(count, 0);
+  const int64_t start_ticks = cv::getTickCount();
+  // One image per task, decoding is as expensive as detection.
+  cv::parallel_for_(cv::Range(0, count), [&](const cv::Range& range) {
+    for (int32_t i = range.start; i < range.end; ++i) {
+      const cv::Mat gray = cv::imread(image_paths[i], cv::IMREAD_GRAYSCALE);
+      if (gray.empty()) continue;
+      megapixels[i] = gray.total() / 1e6;
+      views[i] = board.has_value() ? DetectCharuco(gray, *board, options)
+                                   : DetectChessboard(gray, options);
+      if (views[i].has_value()) {
+        views[i]->image_path = image_paths[i];
+        views[i]->image_size = gray.size();
+      }
+    }
+  }, /*nstripes=*/count);
+
+  CornerDetection result;
+  result.seconds = (cv::getTickCount() - start_ticks) / cv::getTickFrequency();
+  result.images = count;
+  for (int32_t i = 0; i < count; ++i) {
+    result.megapixels += megapixels[i];
+    if (views[i].has_value()) {
+      result.views.push_back(*std::move(views[i]));
+    } else {
+      result.failed_paths.push_back(image_paths[i]);
+    }
+  }
+  return result;
+}
+
+absl::StatusOr<CalibrationResult> CalibrateCamera(
+    const std::vector<ViewCorners>& views, const CalibrationOptions& options) {
+  if (views.empty()) {
+    return absl::FailedPreconditionError("No views to calibrate from");
+  }
+  const cv::Size image_size = views.front().image_size;
+  CalibrationResult result;
+  for (int32_t i = 0; i < static_cast<int32_t>(views.size()); ++i) {
+    if (views[i].image_size != image_size) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          views[i].image_path, " is ", views[i].image_size.width, "x",
+          views[i].image_size.height, ", expected ", image_size.width, "x",
+          image_size.height));
+    }
+    result.used_views.push_back(i);
+  }
+
+  for (int32_t round = 0;; ++round) {
+    if (static_cast<int32_t>(result.used_views.size()) < options.min_views) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("Only ", result.used_views.size(), " usable views, ",
+                       options.min_views, " needed"));
+    }
+    std::vector<std::vector<cv::Point3f>> object_points;
+    std::vector<std::vector<cv::Point2f>> image_points;
+    for (int32_t i : result.used_views) {
+      object_points.push_back(views[i].object_points);
+      image_points.push_back(views[i].image_points);
+    }
+    cv::Mat camera_matrix;
+    cv::Mat distortion_params;
+    std::vector<cv::Mat> rvecs;
+    std::vector<cv::Mat> tvecs;
+    cv::Mat std_intrinsics;
+    cv::Mat std_extrinsics;
+    cv::Mat view_errors;
+    result.reprojection_error = cv::calibrateCamera(
+        object_points, image_points, image_size, camera_matrix,
+        distortion_params, rvecs, tvecs, std_intrinsics, std_extrinsics,
+        view_errors);
+    result.calibration.camera_matrix = camera_matrix;
+    result.calibration.distortion_params = distortion_params.reshape(1, 1);
+    result.view_errors.assign(view_errors.begin<double>(),
+                              view_errors.end<double>());
+
+    if (round == options.max_outlier_rounds) break;
+    // Far off views are dropped even when all are below the threshold
+    // together, they tend to be misdetections.
+    const double threshold = std::max(options.max_view_error_px,
+                                      3 * Median(result.view_errors));
+    std::vector<int32_t> kept;
+    for (size_t i = 0; i < result.used_views.size(); ++i) {
+      if (result.view_errors[i] > threshold) {
+        result.rejected_views.push_back(result.used_views[i]);
+      } else {
+        kept.push_back(result.used_views[i]);
+      }
+    }
+    if (kept.size() == result.used_views.size()) break;
+    result.used_views = std::move(kept);
+  }
+  std::sort(result.rejected_views.begin(), result.rejected_views.end());
+  return result;
+}
+
+}  // namespace aruco
@@ -0,0 +1,76 @@
+// Intrinsic camera calibration from images of a chessboard or ChArUco board.
+// Corner detection, which dominates the run time on high resolution
+// captures, runs on all images in parallel.
+#ifndef CAMERA_CALIBRATION_H
+#define CAMERA_CALIBRATION_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "absl/status/statusor.h"
+#include "opencv2/core.hpp"
+#include "opencv2/objdetect/aruco_dictionary.hpp"
+#include "project_points/projection.h"
+
+namespace aruco {
+
+enum class CalibrationPattern { kChessboard, kCharuco };
+
+struct CalibrationOptions {
+  CalibrationPattern pattern = CalibrationPattern::kChessboard;
+  // Inner corners for a chessboard, squares for a ChArUco board.
+  cv::Size board_size = cv::Size(9, 6);
+  // Board units, they only scale the extrinsics.
+  float square_size = 1.0;
+  // ChArUco marker side in board units.
+  float marker_size = 0.7;
+  cv::aruco::PredefinedDictionaryType dictionary = cv::aruco::DICT_6X6_250;
+  // ChArUco views with fewer corners are skipped.
+  int32_t min_charuco_corners = 8;
+  // Views whose RMS reprojection error exceeds this are dropped and the
+  // camera is calibrated again, up to max_outlier_rounds times.
+  double max_view_error_px = 1.0;
+  int32_t max_outlier_rounds = 3;
+  // Minimum views to calibrate from.
+  int32_t min_views = 5;
+};
+
+struct ViewCorners {
+  std::string image_path;
+  cv::Size image_size;
+  std::vector<cv::Point3f> object_points;
+  std::vector<cv::Point2f> image_points;
+};
+
+struct CornerDetection {
+  // Images the board was found in, in input order.
+  std::vector<ViewCorners> views;
+  // Images that could not be read or had no board.
+  std::vector<std::string> failed_paths;
+  int32_t images = 0;
+  double megapixels = 0;
+  double seconds = 0;
+};
+
+// Reads the images and detects board corners in parallel.
+CornerDetection DetectCalibrationCorners(
+    const std::vector<std::string>& image_paths,
+    const CalibrationOptions& options);
+
+struct CalibrationResult {
+  IntrinsicCalibration calibration;
+  // RMS reprojection error over the used views in pixels.
+  double reprojection_error = 0;
+  // Indices into the input views and their RMS errors of the final run.
+  std::vector<int32_t> used_views;
+  std::vector<double> view_errors;
+  std::vector<int32_t> rejected_views;
+};
+
+// Calibrates from the detected views, dropping outlier views. Views must
+// share one image size.
+absl::StatusOr<CalibrationResult> CalibrateCamera(
+    const std::vector<ViewCorners>& views, const CalibrationOptions& options);
+
+}  // namespace aruco
+
+#endif  // CAMERA_CALIBRATION_H
@@ -0,0 +1,170 @@
+#include "project_points/camera_calibration.h"
+#include <cstdlib>
+#include <filesystem>
+#include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+#include "opencv2/calib3d.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/objdetect/aruco_board.hpp"
+
+namespace aruco {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+
+constexpr double kFocal = 900;
+const cv::Size kImageSize(1280, 720);
+// Board image pixels per board unit.
+constexpr double kPixelsPerUnit = 4;
+
+std::string TempPath(const std::string& name) {
+  return (std::filesystem::path(std::getenv("TEST_TMPDIR")) / name).string();
+}
+
+cv::Mat ChessboardImage(const cv::Size& inner_corners, int32_t square_px) {
+  // One square of white margin around the squares.
+  const cv::Size squares = inner_corners + cv::Size(1, 1);
+  cv::Mat board(square_px * (squares.height + 2),
+                square_px * (squares.width + 2), CV_8UC1, cv::Scalar(255));
+  for (int32_t y = 0; y < squares.height; ++y) {
+    for (int32_t x = 0; x < squares.width; ++x) {
+      if ((x + y) % 2 != 0) continue;
+      board(cv::Rect((x + 1) * square_px, (y + 1) * square_px, square_px,
+                     square_px))
+          .setTo(0);
+    }
+  }
+  return board;
+}
+
+// Renders the flat board tilted by rx, ry degrees and centered distance
+// units in front of a distortion free camera.
+cv::Mat RenderView(const cv::Mat& board, double rx, double ry,
+                   double distance) {
+  const cv::Matx33d camera_matrix(kFocal, 0, kImageSize.width / 2.0, 0, kFocal,
+                                  kImageSize.height / 2.0, 0, 0, 1);
+  cv::Matx33d rotation;
+  cv::Rodrigues(cv::Vec3d(rx * CV_PI / 180, ry * CV_PI / 180, 0), rotation);
+  const cv::Vec3d center(board.cols / kPixelsPerUnit / 2,
+                         board.rows / kPixelsPerUnit / 2, 0);
+  const cv::Vec3d tvec = cv::Vec3d(0, 0, distance) - rotation * center;
+  const cv::Matx33d plane_to_camera(rotation(0, 0), rotation(0, 1), tvec[0],
+                                    rotation(1, 0), rotation(1, 1), tvec[1],
+                                    rotation(2, 0), rotation(2, 1), tvec[2]);
+  const cv::Matx33d board_to_plane(1 / kPixelsPerUnit, 0, 0, 0,
+                                   1 / kPixelsPerUnit, 0, 0, 0, 1);
+  cv::Mat view;
+  cv::warpPerspective(board, view,
+                      cv::Mat(camera_matrix * plane_to_camera * board_to_plane),
+                      kImageSize, cv::INTER_LINEAR, cv::BORDER_CONSTANT,
+                      cv::Scalar(128));
+  return view;
+}
+
+std::vector<std::string> WriteViews(const cv::Mat& board,
+                                    const std::string& prefix) {
+  const std::vector<cv::Vec2d> tilts = {{0, 0},    {25, 0},  {-25, 0},
+                                        {0, 25},   {0, -25}, {20, 20},
+                                        {-20, 20}, {20, -20}, {-20, -20}};
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < tilts.size(); ++i) {
+    paths.push_back(TempPath(absl::StrCat(prefix, "_", i, ".png")));
+    EXPECT_TRUE(cv::imwrite(paths.back(),
+                            RenderView(board, tilts[i][0], tilts[i][1], 450)));
+  }
+  return paths;
+}
+
+TEST(CameraCalibration, RecoversIntrinsicsFromChessboard) {
+  CalibrationOptions options;
+  options.board_size = cv::Size(9, 6);
+  options.square_size = 25;
+  std::vector<std::string> paths =
+      WriteViews(ChessboardImage(options.board_size, 100), "chessboard");
+  paths.push_back(TempPath("missing.png"));
+
+  const CornerDetection detection = DetectCalibrationCorners(paths, options);
+  EXPECT_EQ(detection.images, static_cast<int32_t>(paths.size()));
+  EXPECT_THAT(detection.failed_paths, testing::ElementsAre(paths.back()));
+  ASSERT_THAT(detection.views, testing::SizeIs(paths.size() - 1));
+  EXPECT_EQ(detection.views[0].image_path, paths[0]);
+  EXPECT_THAT(detection.views[0].image_points, testing::SizeIs(54));
+
+  const auto result = CalibrateCamera(detection.views, options);
+  ASSERT_THAT(result, IsOk());
+  EXPECT_THAT(result->rejected_views, testing::IsEmpty());
+  EXPECT_LT(result->reprojection_error, 0.5);
+  const cv::Mat& camera_matrix = result->calibration.camera_matrix;
+  EXPECT_NEAR(camera_matrix.at<double>(0, 0), kFocal, kFocal * 0.02);
+  EXPECT_NEAR(camera_matrix.at<double>(1, 1), kFocal, kFocal * 0.02);
+  EXPECT_NEAR(camera_matrix.at<double>(0, 2), kImageSize.width / 2.0, 15);
+  EXPECT_NEAR(camera_matrix.at<double>(1, 2), kImageSize.height / 2.0, 15);
+}
+
+TEST(CameraCalibration, RejectsOutlierViews) {
+  CalibrationOptions options;
+  options.square_size = 25;
+  const CornerDetection detection = DetectCalibrationCorners(
+      WriteViews(ChessboardImage(options.board_size, 100), "outlier"),
+      options);
+  std::vector<ViewCorners> views = detection.views;
+  ASSERT_THAT(views, testing::SizeIs(9));
+  // A view with badly misplaced corners, as from a misdetection.
+  ViewCorners outlier = views[1];
+  cv::RNG rng(1);
+  for (cv::Point2f& point : outlier.image_points) {
+    point += cv::Point2f(rng.gaussian(4), rng.gaussian(4));
+  }
+  views.push_back(outlier);
+
+  const auto result = CalibrateCamera(views, options);
+  ASSERT_THAT(result, IsOk());
+  EXPECT_THAT(result->rejected_views, testing::ElementsAre(9));
+  EXPECT_THAT(result->used_views, testing::SizeIs(9));
+  EXPECT_LT(result->reprojection_error, 0.5);
+}
+
+TEST(CameraCalibration, DetectsCharucoBoard) {
+  CalibrationOptions options;
+  options.pattern = CalibrationPattern::kCharuco;
+  options.board_size = cv::Size(8, 6);
+  options.square_size = 25;
+  options.marker_size = 18;
+  const cv::aruco::CharucoBoard board(
+      options.board_size, options.square_size, options.marker_size,
+      cv::aruco::getPredefinedDictionary(options.dictionary));
+  cv::Mat board_image;
+  // 100 px squares with one square margin, matching kPixelsPerUnit.
+  board.generateImage(cv::Size(1000, 800), board_image, /*marginSize=*/100);
+
+  const CornerDetection detection =
+      DetectCalibrationCorners(WriteViews(board_image, "charuco"), options);
+  ASSERT_THAT(detection.views, testing::SizeIs(9));
+  EXPECT_THAT(detection.views[0].image_points, testing::SizeIs(35));
+
+  const auto result = CalibrateCamera(detection.views, options);
+  ASSERT_THAT(result, IsOk());
+  EXPECT_NEAR(result->calibration.camera_matrix.at<double>(0, 0), kFocal,
+              kFocal * 0.02);
+}
+
+TEST(CameraCalibration, NeedsEnoughViews) {
+  CalibrationOptions options;
+  EXPECT_THAT(CalibrateCamera({}, options),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  ViewCorners view;
+  view.image_size = kImageSize;
+  EXPECT_THAT(CalibrateCamera({view, view}, options),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  ViewCorners other = view;
+  other.image_size = cv::Size(640, 480);
+  EXPECT_THAT(CalibrateCamera({view, other}, options),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace aruco
@@ -7,9 +7,11 @@
 #include "glog/logging.h"
 #include "opencv2/core.hpp"
 #include "opencv2/highgui.hpp"
+#include "opencv2/objdetect/aruco_detector.hpp"
 #include "opencv2/objdetect/aruco_dictionary.hpp"
 #include "project_points/highgui_utils.h"
 #include "project_points/proto_utils.h"
+#include "project_points/trace.h"
 #include "projection.h"
 #include "status_macros.h"
 
@@ -20,23 +22,34 @@ ABSL_FLAG(std::string, image_path, "testdata/frame_1.jpg",
 ABSL_FLAG(std::string, detector_type, "aruco",
           "Type of detector. aruco or corners.");
 
+ABSL_FLAG(std::string, detector_params_path, "",
+          "DetectorParams text proto from tune_detector_main. Empty uses the "
+          "OpenCV defaults.");
+
+ABSL_FLAG(std::string, trace_path, "",
+          "Writes a Chrome trace event timeline, for chrome://tracing or "
+          "ui.perfetto.dev");
+
 absl::Status DetectArucoRun(const cv::Mat& image) {
-  const cv::aruco::Dictionary dictionary =
-      cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
+  ASSIGN_OR_RETURN(const cv::aruco::DetectorParameters detector_params,
+                   aruco::LoadDetectorParameters(
+                       absl::GetFlag(FLAGS_detector_params_path)));
+  const cv::aruco::ArucoDetector detector(
+      cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250),
+      detector_params);
 
   LOG(INFO) << "Image size: " << image.size;
-  const std::unordered_map<int32_t, cv::Point> detected_points =
-      aruco::DetectArucoPoints(image, dictionary);
-  for (const auto& [id, point] : detected_points) {
-    LOG(INFO) << id << " " << point.x << " " << point.y;
+  const aruco::DetectedMarkers detected_points =
+      aruco::DetectArucoPoints(image, detector);
+  for (const aruco::DetectedMarker& marker : detected_points) {
+    LOG(INFO) << marker.id << " " << marker.center.x << " " << marker.center.y;
   }
 
   const std::vector<cv::Scalar> corner_colors = {
       aruco::kMAGENTA, aruco::kCYAN, aruco::kYELLOW, aruco::kORANGE};
-  for (int i = 1; i <= 4; ++i) {
-    if (detected_points.contains(i)) {
-      aruco::DrawCircle(image, detected_points.at(i), corner_colors[i - 1]);
-    }
+  for (const aruco::DetectedMarker& marker : detected_points) {
+    if (marker.id < 1 || marker.id > 4) continue;
+    aruco::DrawCircle(image, marker.center, corner_colors[marker.id - 1]);
   }
 
   if (!detected_points.empty()) {
@@ -50,21 +63,21 @@ absl::Status DetectArucoRun(const cv::Mat& image) {
 }
 
 absl::Status DetectCorners(const cv::Mat& image) {
-  std::unordered_map<int32_t, cv::Point> detected_points =
-      aruco::DetectCorners(image);
+  const aruco::DetectedMarkers detected_points = [&image]() {
+    aruco::TraceScope scope("detect_corners");
+    return aruco::DetectCorners(image);
+  }();
 
   if (detected_points.empty()) return absl::OkStatus();
 
-  for (const auto& [id, point] : detected_points) {
-    LOG(INFO) << id << " " << point.x << " " << point.y;
+  for (const aruco::DetectedMarker& corner : detected_points) {
+    LOG(INFO) << corner.id << " " << corner.center.x << " " << corner.center.y;
   }
 
   const std::vector<cv::Scalar> corner_colors = {
       aruco::kMAGENTA, aruco::kCYAN, aruco::kYELLOW, aruco::kORANGE};
-  for (int i = 1; i <= 4; ++i) {
-    if (detected_points.contains(i)) {
-      aruco::DrawCircle(image, detected_points.at(i), corner_colors[i - 1]);
-    }
+  for (const aruco::DetectedMarker& corner : detected_points) {
+    aruco::DrawCircle(image, corner.center, corner_colors[corner.id - 1]);
   }
   constexpr absl::string_view kWindow = "Detection";
   cv::namedWindow(kWindow.data(), cv::WINDOW_FREERATIO);
@@ -74,7 +87,10 @@ absl::Status DetectCorners(const cv::Mat& image) {
 }
 
 absl::Status Run() {
-  cv::Mat image = cv::imread(absl::GetFlag(FLAGS_image_path));
+  cv::Mat image = [&]() {
+    aruco::TraceScope scope("read");
+    return cv::imread(absl::GetFlag(FLAGS_image_path));
+  }();
   if (image.empty()) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Failed to load image '%s'", absl::GetFlag(FLAGS_image_path)));
@@ -87,13 +103,23 @@ absl::Status Run() {
     return absl::InvalidArgumentError(absl::StrCat(
         "Invalid detector type:", absl::GetFlag(FLAGS_detector_type)));
   };
+  return absl::OkStatus();
 }
 
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   absl::ParseCommandLine(argc, argv);
   gflags::SetCommandLineOption("logtostderr", "1");
-  if (const auto status = Run(); !status.ok()) {
+  if (const std::string trace_path = absl::GetFlag(FLAGS_trace_path);
+      !trace_path.empty()) {
+    aruco::trace::Start(trace_path);
+    aruco::trace::SetThreadName("main");
+  }
+  const auto status = Run();
+  if (const auto trace_status = aruco::trace::Stop(); !trace_status.ok()) {
+    LOG(WARNING) << "Trace: " << trace_status.message();
+  }
+  if (!status.ok()) {
     LOG(ERROR) << "Failed: " << status.message();
     return EXIT_FAILURE;
   }
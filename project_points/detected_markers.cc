@@ -0,0 +1,52 @@
+#include "project_points/detected_markers.h"
+#include <algorithm>
+#include <cmath>
+
+namespace aruco {
+
+cv::Point2f MarkerCenter(const std::array<cv::Point2f, 4>& corners) {
+  // Solves corners[0] + s * d0 = corners[1] + t * d1.
+  const cv::Point2f d0 = corners[2] - corners[0];
+  const cv::Point2f d1 = corners[3] - corners[1];
+  const float denominator = d0.cross(d1);
+  const cv::Point2f mean =
+      (corners[0] + corners[1] + corners[2] + corners[3]) * 0.25f;
+  if (std::abs(denominator) < 1e-6f) return mean;
+  const float s = (corners[1] - corners[0]).cross(d1) / denominator;
+  return corners[0] + s * d0;
+}
+
+bool DetectedMarkers::Insert(const DetectedMarker& marker) {
+  DetectedMarker* const first = markers_.data();
+  DetectedMarker* const last = first + size_;
+  DetectedMarker* position = std::lower_bound(
+      first, last, marker.id,
+      [](const DetectedMarker& m, int32_t value) { return m.id < value; });
+  if (position != last && position->id == marker.id) {
+    *position = marker;
+    return true;
+  }
+  if (size_ == kCapacity) {
+    ++dropped_;
+    return false;
+  }
+  std::move_backward(position, last, last + 1);
+  *position = marker;
+  ++size_;
+  return true;
+}
+
+const DetectedMarker* DetectedMarkers::Find(int32_t id) const {
+  const DetectedMarker* position = std::lower_bound(
+      begin(), end(), id,
+      [](const DetectedMarker& m, int32_t value) { return m.id < value; });
+  return position != end() && position->id == id ? position : nullptr;
+}
+
+const DetectedMarker& DetectedMarkers::at(int32_t id) const {
+  const DetectedMarker* marker = Find(id);
+  CV_Assert(marker != nullptr);
+  return *marker;
+}
+
+}  // namespace aruco
@@ -0,0 +1,64 @@
+// Detection result without heap allocation. A frame has a handful of
+// markers, so they are kept inline, sorted by id, and looked up by binary
+// search.
+#ifndef DETECTED_MARKERS_H
+#define DETECTED_MARKERS_H
+#include <array>
+#include <cstdint>
+#include "opencv2/core.hpp"
+
+namespace aruco {
+
+struct DetectedMarker {
+  int32_t id = 0;
+  // Corners in detector order, clockwise from the top left corner of the
+  // marker. Contour vertices unless the detector parameters refine corners.
+  // Point detections without extent repeat the center.
+  std::array<cv::Point2f, 4> corners;
+  // Projection of the marker center, see MarkerCenter.
+  cv::Point2f center;
+};
+
+// Intersection of the diagonals. Unlike the mean or the bounding box center
+// it is the image of the square's center under perspective.
+cv::Point2f MarkerCenter(const std::array<cv::Point2f, 4>& corners);
+
+class DetectedMarkers {
+ public:
+  static constexpr int32_t kCapacity = 64;
+  using value_type = DetectedMarker;
+  using size_type = size_t;
+  using const_iterator = const DetectedMarker*;
+  using iterator = const_iterator;
+
+  // Adds the marker keeping ids sorted, replaces a marker with the same id.
+  // Returns false and counts the marker as dropped if full.
+  bool Insert(const DetectedMarker& marker);
+
+  // Markers Insert rejected because the container was full.
+  int32_t dropped() const { return dropped_; }
+
+  // Nullptr if id was not detected.
+  const DetectedMarker* Find(int32_t id) const;
+  bool contains(int32_t id) const { return Find(id) != nullptr; }
+  // Id must be detected.
+  const DetectedMarker& at(int32_t id) const;
+
+  const DetectedMarker* begin() const { return markers_.data(); }
+  const DetectedMarker* end() const { return markers_.data() + size_; }
+  size_t size() const { return static_cast<size_t>(size_); }
+  bool empty() const { return size_ == 0; }
+  void clear() {
+    size_ = 0;
+    dropped_ = 0;
+  }
+
+ private:
+  std::array<DetectedMarker, kCapacity> markers_;
+  int32_t size_ = 0;
+  int32_t dropped_ = 0;
+};
+
+}  // namespace aruco
+
+#endif  // DETECTED_MARKERS_H
@@ -0,0 +1,80 @@
+#include "project_points/detected_markers.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+
+namespace aruco {
+namespace {
+
+DetectedMarker Marker(int32_t id, cv::Point2f center) {
+  DetectedMarker marker;
+  marker.id = id;
+  marker.corners.fill(center);
+  marker.center = center;
+  return marker;
+}
+
+TEST(DetectedMarkers, KeepsIdsSorted) {
+  DetectedMarkers markers;
+  EXPECT_TRUE(markers.empty());
+  for (int32_t id : {7, 2, 9, 1, 4}) {
+    ASSERT_TRUE(markers.Insert(Marker(id, cv::Point2f(id, 0))));
+  }
+  std::vector<int32_t> ids;
+  for (const DetectedMarker& marker : markers) ids.push_back(marker.id);
+  EXPECT_THAT(ids, testing::ElementsAre(1, 2, 4, 7, 9));
+
+  ASSERT_TRUE(markers.contains(4));
+  EXPECT_EQ(markers.at(4).center, cv::Point2f(4, 0));
+  EXPECT_EQ(markers.Find(3), nullptr);
+  EXPECT_EQ(markers.Find(10), nullptr);
+}
+
+TEST(DetectedMarkers, ReplacesSameId) {
+  DetectedMarkers markers;
+  ASSERT_TRUE(markers.Insert(Marker(3, cv::Point2f(1, 1))));
+  ASSERT_TRUE(markers.Insert(Marker(3, cv::Point2f(2, 2))));
+  EXPECT_EQ(markers.size(), 1u);
+  EXPECT_EQ(markers.at(3).center, cv::Point2f(2, 2));
+}
+
+TEST(DetectedMarkers, RejectsBeyondCapacity) {
+  DetectedMarkers markers;
+  for (int32_t id = 0; id < DetectedMarkers::kCapacity; ++id) {
+    ASSERT_TRUE(markers.Insert(Marker(id, cv::Point2f())));
+  }
+  EXPECT_EQ(markers.dropped(), 0);
+  EXPECT_FALSE(markers.Insert(Marker(-1, cv::Point2f())));
+  EXPECT_EQ(markers.dropped(), 1);
+  // Existing ids can still be updated.
+  EXPECT_TRUE(markers.Insert(Marker(5, cv::Point2f(1, 1))));
+  EXPECT_EQ(markers.size(), static_cast<size_t>(DetectedMarkers::kCapacity));
+  EXPECT_EQ(markers.dropped(), 1);
+  markers.clear();
+  EXPECT_TRUE(markers.empty());
+  EXPECT_EQ(markers.dropped(), 0);
+}
+
+TEST(MarkerCenter, IsPerspectiveCorrect) {
+  // Marker seen in perspective: top edge further away and shorter. The
+  // diagonals meet closer to the far edge than the corner mean does.
+  const std::array<cv::Point2f, 4> corners = {
+      cv::Point2f(40, 0), cv::Point2f(60, 0), cv::Point2f(100, 100),
+      cv::Point2f(0, 100)};
+  const cv::Point2f center = MarkerCenter(corners);
+  EXPECT_NEAR(center.x, 50, 1e-4);
+  EXPECT_NEAR(center.y, 100.0 / 6.0, 1e-4);
+
+  const std::array<cv::Point2f, 4> square = {
+      cv::Point2f(0, 0), cv::Point2f(2, 0), cv::Point2f(2, 2),
+      cv::Point2f(0, 2)};
+  EXPECT_EQ(MarkerCenter(square), cv::Point2f(1, 1));
+}
+
+TEST(MarkerCenter, FallsBackToMeanWhenDegenerate) {
+  std::array<cv::Point2f, 4> corners;
+  corners.fill(cv::Point2f(3, 4));
+  EXPECT_EQ(MarkerCenter(corners), cv::Point2f(3, 4));
+}
+
+}  // namespace
+}  // namespace aruco
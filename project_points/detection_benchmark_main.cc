@@ -0,0 +1,130 @@
+// Throughput of the detection daemon with concurrent clients. Start
+// detection_daemon_main first, with at least --clients clients.
+// bazel run //project_points:detection_benchmark_main -- --clients=4
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "opencv2/imgcodecs.hpp"
+#include "project_points/detection_client.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, image_path, "testdata/frame_0.jpg",
+          "Frame submitted by every client");
+
+ABSL_FLAG(std::string, channel_prefix,
+          std::string(aruco::kDefaultDetectionChannelPrefix),
+          "Shared memory name prefix of the daemon");
+
+ABSL_FLAG(int32_t, max_clients, aruco::DetectionServerOptions().max_clients,
+          "Channel count of the daemon");
+
+ABSL_FLAG(int32_t, clients, 2, "Concurrent clients");
+
+ABSL_FLAG(int32_t, frames, 500, "Frames per client");
+
+ABSL_FLAG(int32_t, depth, 2, "Frames in flight per client");
+
+namespace {
+
+struct ClientStats {
+  absl::Status status;
+  std::vector<int64_t> latencies_ns;
+  int64_t failed_frames = 0;
+  double seconds = 0;
+};
+
+double Percentile(std::vector<int64_t> values, double p) {
+  if (values.empty()) return 0;
+  const size_t index = std::min(values.size() - 1,
+                                static_cast<size_t>(p * values.size()));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index] / 1e6;
+}
+
+absl::Status RunClient(const cv::Mat& image, ClientStats& stats) {
+  ASSIGN_OR_RETURN(auto client,
+                   aruco::DetectionClient::Connect(
+                       absl::GetFlag(FLAGS_channel_prefix),
+                       absl::GetFlag(FLAGS_max_clients)));
+  const int32_t frames = absl::GetFlag(FLAGS_frames);
+  const uint64_t depth = absl::GetFlag(FLAGS_depth);
+  stats.latencies_ns.reserve(frames);
+  const int64_t start_ns = aruco::MonotonicNowNs();
+  int32_t submitted = 0;
+  while (static_cast<int64_t>(stats.latencies_ns.size()) +
+             stats.failed_frames <
+         frames) {
+    while (submitted < frames && client->in_flight() < depth) {
+      ASSIGN_OR_RETURN(cv::Mat slot,
+                       client->AcquireFrame(image.size(), image.type()));
+      // Stands in for the camera writing into the slot.
+      image.copyTo(slot);
+      RETURN_IF_ERROR(client->Submit().status());
+      ++submitted;
+    }
+    ASSIGN_OR_RETURN(const aruco::DetectionResult result, client->Wait());
+    if (result.status.ok()) {
+      stats.latencies_ns.push_back(result.latency_ns);
+    } else {
+      ++stats.failed_frames;
+    }
+  }
+  stats.seconds = (aruco::MonotonicNowNs() - start_ns) / 1e9;
+  return absl::OkStatus();
+}
+
+absl::Status Run() {
+  const cv::Mat image = cv::imread(absl::GetFlag(FLAGS_image_path));
+  if (image.empty()) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Unable to read image %s", absl::GetFlag(FLAGS_image_path)));
+  }
+  const int32_t client_count = absl::GetFlag(FLAGS_clients);
+  std::vector<ClientStats> stats(client_count);
+  std::vector<std::thread> threads;
+  for (int32_t i = 0; i < client_count; ++i) {
+    threads.emplace_back([&image, &stats, i]() {
+      stats[i].status = RunClient(image, stats[i]);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  std::vector<int64_t> all_latencies_ns;
+  double total_fps = 0;
+  for (int32_t i = 0; i < client_count; ++i) {
+    RETURN_IF_ERROR(stats[i].status);
+    const double fps = stats[i].latencies_ns.size() / stats[i].seconds;
+    total_fps += fps;
+    LOG(INFO) << absl::StrFormat(
+        "Client %d: %.1f fps, p50 %.2f ms, p99 %.2f ms, %d failed", i, fps,
+        Percentile(stats[i].latencies_ns, 0.5),
+        Percentile(stats[i].latencies_ns, 0.99), stats[i].failed_frames);
+    all_latencies_ns.insert(all_latencies_ns.end(),
+                            stats[i].latencies_ns.begin(),
+                            stats[i].latencies_ns.end());
+  }
+  LOG(INFO) << absl::StrFormat(
+      "Total: %d clients, %dx%d frames, %.1f fps, p50 %.2f ms, p99 %.2f ms",
+      client_count, image.cols, image.rows, total_fps,
+      Percentile(all_latencies_ns, 0.5), Percentile(all_latencies_ns, 0.99));
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  gflags::SetCommandLineOption("logtostderr", "1");
+  if (const auto status = Run(); !status.ok()) {
+    LOG(ERROR) << "Failed: " << status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
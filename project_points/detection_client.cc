@@ -0,0 +1,171 @@
+#include "project_points/detection_client.h"
+#include <signal.h>
+#include <unistd.h>
+#include <cerrno>
+#include "absl/strings/str_cat.h"
+
+namespace aruco {
+namespace {
+
+bool ProcessAlive(int32_t pid) {
+  return ::kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+// Claims the channel for this process, taking it over from a dead owner.
+bool Claim(ShmChannelHeader& header) {
+  const int32_t self = static_cast<int32_t>(::getpid());
+  int32_t owner = header.owner_pid.load(std::memory_order_acquire);
+  while (owner == 0 || !ProcessAlive(owner)) {
+    if (header.owner_pid.compare_exchange_weak(owner, self,
+                                               std::memory_order_acq_rel)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<DetectionClient>> DetectionClient::Connect(
+    absl::string_view channel_prefix, int32_t max_clients,
+    absl::Duration drain_timeout) {
+  bool found = false;
+  for (int32_t i = 0; i < max_clients; ++i) {
+    auto channel = ShmChannel::Open(ShmChannelName(channel_prefix, i));
+    if (!channel.ok()) continue;
+    found = true;
+    ShmChannelHeader& header = (*channel)->header();
+    if (!Claim(header)) continue;
+
+    // A previous owner may have died with frames in flight. Let the daemon
+    // drain them and drop their results.
+    Backoff backoff;
+    const absl::Time deadline = absl::Now() + drain_timeout;
+    const uint64_t request_head =
+        header.request_head.load(std::memory_order_relaxed);
+    uint64_t result_head = header.result_head.load(std::memory_order_acquire);
+    header.result_tail.store(result_head, std::memory_order_release);
+    while (header.request_tail.load(std::memory_order_acquire) !=
+           request_head) {
+      if (absl::Now() > deadline) {
+        header.owner_pid.store(0, std::memory_order_release);
+        return absl::UnavailableError(absl::StrCat(
+            "Detection daemon did not drain channel ", i, " of ",
+            channel_prefix, " within ", absl::FormatDuration(drain_timeout)));
+      }
+      backoff.Wait();
+      result_head = header.result_head.load(std::memory_order_acquire);
+      header.result_tail.store(result_head, std::memory_order_release);
+    }
+    result_head = header.result_head.load(std::memory_order_acquire);
+    header.result_tail.store(result_head, std::memory_order_release);
+
+    std::unique_ptr<DetectionClient> client(
+        new DetectionClient(*std::move(channel)));
+    client->next_sequence_ = request_head;
+    client->next_result_ = result_head;
+    return client;
+  }
+  if (!found) {
+    return absl::UnavailableError(
+        absl::StrCat("Detection daemon is not running at ", channel_prefix));
+  }
+  return absl::ResourceExhaustedError(
+      absl::StrCat("All ", max_clients, " detection channels are in use"));
+}
+
+DetectionClient::DetectionClient(std::unique_ptr<ShmChannel> channel)
+    : channel_(std::move(channel)) {}
+
+DetectionClient::~DetectionClient() {
+  channel_->header().owner_pid.store(0, std::memory_order_release);
+}
+
+absl::StatusOr<cv::Mat> DetectionClient::AcquireFrame(cv::Size size,
+                                                      int32_t type) {
+  // Unconsumed results keep their slots too, so the daemon never blocks on a
+  // full result ring.
+  if (in_flight() >= channel_->slot_count()) {
+    return absl::ResourceExhaustedError("All frame slots are in flight");
+  }
+  // Rows aligned to cache lines.
+  const uint64_t row_bytes =
+      static_cast<uint64_t>(size.width) * CV_ELEM_SIZE(type);
+  const uint64_t step = (row_bytes + 63) / 64 * 64;
+  if (size.width <= 0 || size.height <= 0 ||
+      step * size.height > channel_->max_frame_bytes()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Frame ", size.width, "x", size.height, " does not fit in ",
+        channel_->max_frame_bytes(), " bytes"));
+  }
+  ShmFrameSlot& slot = channel_->frame_slot(next_sequence_);
+  slot.rows = size.height;
+  slot.cols = size.width;
+  slot.type = type;
+  slot.step = step;
+  acquired_ = true;
+  return cv::Mat(size, type, channel_->frame_data(next_sequence_), step);
+}
+
+absl::StatusOr<uint64_t> DetectionClient::Submit() {
+  if (!acquired_) {
+    return absl::FailedPreconditionError("No frame was acquired");
+  }
+  acquired_ = false;
+  ShmFrameSlot& slot = channel_->frame_slot(next_sequence_);
+  slot.sequence = next_sequence_;
+  slot.submit_ns = MonotonicNowNs();
+  channel_->header().request_head.store(++next_sequence_,
+                                        std::memory_order_release);
+  return slot.sequence;
+}
+
+absl::StatusOr<uint64_t> DetectionClient::Submit(const cv::Mat& frame) {
+  absl::StatusOr<cv::Mat> slot = AcquireFrame(frame.size(), frame.type());
+  if (!slot.ok()) return slot.status();
+  frame.copyTo(*slot);
+  return Submit();
+}
+
+std::optional<DetectionResult> DetectionClient::Poll() {
+  ShmChannelHeader& header = channel_->header();
+  if (header.result_head.load(std::memory_order_acquire) == next_result_) {
+    return std::nullopt;
+  }
+  const ShmResultSlot& slot = channel_->result_slot(next_result_);
+  DetectionResult result;
+  result.sequence = slot.sequence;
+  if (slot.status_code != 0) {
+    result.status = absl::Status(
+        static_cast<absl::StatusCode>(slot.status_code), "Detection failed");
+  }
+  result.markers = slot.markers;
+  result.items.reserve(slot.item_count);
+  for (int32_t i = 0; i < slot.item_count; ++i) {
+    const ShmPoint& item = slot.items[i];
+    result.items.push_back(
+        ItemPosition{.id = item.id, .point = cv::Point2f(item.x, item.y)});
+  }
+  result.processing_ns = slot.processing_ns;
+  result.latency_ns = MonotonicNowNs() - slot.submit_ns;
+  header.result_tail.store(++next_result_, std::memory_order_release);
+  return result;
+}
+
+absl::StatusOr<DetectionResult> DetectionClient::Wait(absl::Duration timeout) {
+  if (in_flight() == 0) {
+    return absl::FailedPreconditionError("No frame in flight");
+  }
+  const absl::Time deadline = absl::Now() + timeout;
+  Backoff backoff;
+  while (true) {
+    std::optional<DetectionResult> result = Poll();
+    if (result.has_value()) return *std::move(result);
+    if (absl::Now() > deadline) {
+      return absl::DeadlineExceededError("Detection daemon did not respond");
+    }
+    backoff.Wait();
+  }
+}
+
+}  // namespace aruco
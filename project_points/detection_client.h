@@ -0,0 +1,83 @@
+// Client of the detection daemon, see detection_server.h.
+//
+//   ASSIGN_OR_RETURN(auto client, DetectionClient::Connect());
+//   ASSIGN_OR_RETURN(cv::Mat frame, client->AcquireFrame(size, CV_8UC3));
+//   camera.read(frame);  // Written straight into shared memory.
+//   ASSIGN_OR_RETURN(uint64_t sequence, client->Submit());
+//   ASSIGN_OR_RETURN(DetectionResult result, client->Wait());
+//
+// A client is used from one thread. Frames are pipelined up to the slot
+// count of the channel, results come back in submission order.
+#ifndef DETECTION_CLIENT_H
+#define DETECTION_CLIENT_H
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "opencv2/core.hpp"
+#include "project_points/detection_server.h"
+#include "project_points/projection.h"
+#include "project_points/shm_channel.h"
+
+namespace aruco {
+
+struct DetectionResult {
+  uint64_t sequence = 0;
+  // Status of the item projection, e.g. FailedPrecondition when a marker was
+  // not detected.
+  absl::Status status;
+  DetectedMarkers markers;
+  std::vector<ItemPosition> items;
+  // Submission to result, and time spent in the daemon.
+  int64_t latency_ns = 0;
+  int64_t processing_ns = 0;
+};
+
+class DetectionClient {
+ public:
+  // Claims a free channel of the daemon. Channels left by dead clients are
+  // reclaimed once the daemon drained their frames in flight. Unavailable if
+  // that takes longer than drain_timeout, e.g. because the daemon is wedged.
+  static absl::StatusOr<std::unique_ptr<DetectionClient>> Connect(
+      absl::string_view channel_prefix = kDefaultDetectionChannelPrefix,
+      int32_t max_clients = DetectionServerOptions().max_clients,
+      absl::Duration drain_timeout = absl::Seconds(5));
+
+  DetectionClient(const DetectionClient&) = delete;
+  DetectionClient& operator=(const DetectionClient&) = delete;
+  ~DetectionClient();
+
+  // Returns a frame backed by the next free request slot, valid until
+  // Submit. ResourceExhausted when all slots are in flight.
+  absl::StatusOr<cv::Mat> AcquireFrame(cv::Size size, int32_t type);
+
+  // Publishes the acquired frame and returns its sequence number.
+  absl::StatusOr<uint64_t> Submit();
+
+  // Copies frame into the next slot and submits it.
+  absl::StatusOr<uint64_t> Submit(const cv::Mat& frame);
+
+  // Next result if there is one.
+  std::optional<DetectionResult> Poll();
+
+  // Waits for the next result. DeadlineExceeded on timeout.
+  absl::StatusOr<DetectionResult> Wait(
+      absl::Duration timeout = absl::Seconds(5));
+
+  // Frames submitted and not yet returned by Poll or Wait.
+  uint64_t in_flight() const { return next_sequence_ - next_result_; }
+
+ private:
+  explicit DetectionClient(std::unique_ptr<ShmChannel> channel);
+
+  std::unique_ptr<ShmChannel> channel_;
+  uint64_t next_sequence_ = 0;
+  uint64_t next_result_ = 0;
+  bool acquired_ = false;
+};
+
+}  // namespace aruco
+
+#endif  // DETECTION_CLIENT_H
@@ -0,0 +1,89 @@
+// Resident detection daemon. Clients connect with DetectionClient.
+// bazel run //project_points:detection_daemon_main --
+// --manifest_path=testdata/simple_manifest.txtpb
+#include <signal.h>
+#include <atomic>
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/status/status.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "project_points/detection_server.h"
+#include "project_points/proto_utils.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, calibration_path, "testdata/pixel_6a_calibration.txtpb",
+          "Intrinsic camera calibration");
+
+ABSL_FLAG(std::string, manifest_path, "testdata/simple_manifest.txtpb",
+          "Manifest text proto file");
+
+ABSL_FLAG(std::string, channel_prefix,
+          std::string(aruco::kDefaultDetectionChannelPrefix),
+          "Shared memory name prefix of the client channels");
+
+ABSL_FLAG(int32_t, max_clients, aruco::DetectionServerOptions().max_clients,
+          "Number of concurrent clients, one serving thread each");
+
+ABSL_FLAG(int32_t, slot_count,
+          static_cast<int32_t>(aruco::DetectionServerOptions().slot_count),
+          "Frames in flight per client");
+
+ABSL_FLAG(int64_t, max_frame_bytes,
+          static_cast<int64_t>(aruco::DetectionServerOptions().max_frame_bytes),
+          "Largest frame clients can submit");
+
+ABSL_FLAG(std::string, detector_params_path, "",
+          "DetectorParams text proto from tune_detector_main. Empty uses the "
+          "OpenCV defaults.");
+
+namespace {
+
+std::atomic<bool> stop_requested{false};
+
+void HandleSignal(int) { stop_requested.store(true); }
+
+absl::Status Run() {
+  ASSIGN_OR_RETURN(
+      const auto calibration_proto,
+      aruco::LoadFromTextProtoFile<aruco::proto::IntrinsicCalibration>(
+          absl::GetFlag(FLAGS_calibration_path)));
+  ASSIGN_OR_RETURN(const auto manifest,
+                   aruco::LoadFromTextProtoFile<aruco::proto::Context>(
+                       absl::GetFlag(FLAGS_manifest_path)));
+
+  aruco::DetectionServerOptions options;
+  options.channel_prefix = absl::GetFlag(FLAGS_channel_prefix);
+  options.max_clients = absl::GetFlag(FLAGS_max_clients);
+  options.slot_count = absl::GetFlag(FLAGS_slot_count);
+  options.max_frame_bytes = absl::GetFlag(FLAGS_max_frame_bytes);
+  ASSIGN_OR_RETURN(options.detector_params,
+                   aruco::LoadDetectorParameters(
+                       absl::GetFlag(FLAGS_detector_params_path)));
+  ASSIGN_OR_RETURN(
+      auto server,
+      aruco::DetectionServer::Create(
+          aruco::ConvertIntrinsicCalibrationFromProto(calibration_proto),
+          aruco::ConvertContextFromProto(manifest), options));
+
+  ::signal(SIGINT, HandleSignal);
+  ::signal(SIGTERM, HandleSignal);
+  LOG(INFO) << "Serving " << options.max_clients << " clients at "
+            << options.channel_prefix;
+  server->Run(stop_requested);
+  LOG(INFO) << "Stopped";
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  gflags::SetCommandLineOption("logtostderr", "1");
+  if (const auto status = Run(); !status.ok()) {
+    LOG(ERROR) << "Failed: " << status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
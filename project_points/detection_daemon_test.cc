@@ -0,0 +1,141 @@
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+#include "opencv2/imgcodecs.hpp"
+#include "project_points/detection_client.h"
+#include "project_points/detection_server.h"
+#include "project_points/proto_utils.h"
+#include "project_points/shm_channel.h"
+#include "tools/cpp/runfiles/runfiles.h"
+
+namespace aruco {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::bazel::tools::cpp::runfiles::Runfiles;
+
+class DetectionDaemonTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    files_.reset(Runfiles::CreateForTest());
+    auto calibration_proto =
+        LoadFromTextProtoFile<aruco::proto::IntrinsicCalibration>(
+            files_->Rlocation("_main/testdata/pixel_6a_calibration.txtpb"));
+    ASSERT_THAT(calibration_proto, IsOk());
+    auto manifest = LoadFromTextProtoFile<aruco::proto::Context>(
+        files_->Rlocation("_main/testdata/simple_manifest.txtpb"));
+    ASSERT_THAT(manifest, IsOk());
+
+    // Unique per process so parallel test runs don't collide.
+    options_.channel_prefix = absl::StrCat("/aruco_test_", ::getpid());
+    options_.max_clients = 2;
+    options_.slot_count = 2;
+    options_.max_frame_bytes = 1920 * 1080 * 3;
+    auto server = DetectionServer::Create(
+        ConvertIntrinsicCalibrationFromProto(*calibration_proto),
+        ConvertContextFromProto(*manifest), options_);
+    ASSERT_THAT(server, IsOk());
+    server_ = *std::move(server);
+    thread_ = std::thread([this]() { server_->Run(stop_); });
+  }
+
+  void TearDown() override {
+    stop_.store(true);
+    if (thread_.joinable()) thread_.join();
+  }
+
+  std::unique_ptr<Runfiles> files_;
+  DetectionServerOptions options_;
+  std::unique_ptr<DetectionServer> server_;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+TEST_F(DetectionDaemonTest, DetectsAndProjects) {
+  const cv::Mat image =
+      cv::imread(files_->Rlocation("_main/testdata/frame_0.jpg"));
+  ASSERT_FALSE(image.empty());
+  auto client =
+      DetectionClient::Connect(options_.channel_prefix, options_.max_clients);
+  ASSERT_THAT(client, IsOk());
+
+  // Twice to go around the ring.
+  for (uint32_t i = 0; i < 2 * options_.slot_count; ++i) {
+    auto sequence = (*client)->Submit(image);
+    ASSERT_THAT(sequence, IsOk());
+    auto result = (*client)->Wait();
+    ASSERT_THAT(result, IsOk());
+    EXPECT_EQ(result->sequence, *sequence);
+    EXPECT_THAT(result->status, IsOk());
+    EXPECT_THAT(result->markers, testing::SizeIs(4));
+    EXPECT_THAT(result->items, testing::SizeIs(1));
+    EXPECT_GT(result->latency_ns, 0);
+  }
+}
+
+TEST_F(DetectionDaemonTest, PipelinesUpToSlotCount) {
+  const cv::Mat image(480, 640, CV_8UC1, cv::Scalar(255));
+  auto client =
+      DetectionClient::Connect(options_.channel_prefix, options_.max_clients);
+  ASSERT_THAT(client, IsOk());
+  for (uint32_t i = 0; i < options_.slot_count; ++i) {
+    ASSERT_THAT((*client)->Submit(image), IsOk());
+  }
+  EXPECT_THAT((*client)->Submit(image),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+  for (uint32_t i = 0; i < options_.slot_count; ++i) {
+    auto result = (*client)->Wait();
+    ASSERT_THAT(result, IsOk());
+    EXPECT_EQ(result->sequence, i);
+    // Nothing to detect on a blank frame.
+    EXPECT_THAT(result->status,
+                StatusIs(absl::StatusCode::kFailedPrecondition));
+    EXPECT_THAT(result->markers, testing::IsEmpty());
+  }
+}
+
+TEST_F(DetectionDaemonTest, RejectsClientsBeyondChannelCount) {
+  std::vector<std::unique_ptr<DetectionClient>> clients;
+  for (int32_t i = 0; i < options_.max_clients; ++i) {
+    auto client =
+        DetectionClient::Connect(options_.channel_prefix, options_.max_clients);
+    ASSERT_THAT(client, IsOk());
+    clients.push_back(*std::move(client));
+  }
+  EXPECT_THAT(
+      DetectionClient::Connect(options_.channel_prefix, options_.max_clients),
+      StatusIs(absl::StatusCode::kResourceExhausted));
+
+  // Disconnecting frees the channel.
+  clients.pop_back();
+  EXPECT_THAT(
+      DetectionClient::Connect(options_.channel_prefix, options_.max_clients),
+      IsOk());
+}
+
+TEST(DetectionClient, TimesOutOnUndrainedChannel) {
+  // A channel with a frame in flight and nobody serving it, as left by a
+  // crashed or wedged daemon.
+  const std::string prefix = absl::StrCat("/aruco_test_wedged_", ::getpid());
+  auto channel = ShmChannel::Create(ShmChannelName(prefix, 0),
+                                    /*slot_count=*/2, /*max_frame_bytes=*/64);
+  ASSERT_THAT(channel, IsOk());
+  (*channel)->header().request_head.store(1);
+  EXPECT_THAT(DetectionClient::Connect(prefix, 1, absl::Milliseconds(50)),
+              StatusIs(absl::StatusCode::kUnavailable));
+  // The claim is released again.
+  EXPECT_EQ((*channel)->header().owner_pid.load(), 0);
+}
+
+TEST(DetectionClient, FailsWithoutDaemon) {
+  EXPECT_THAT(DetectionClient::Connect("/aruco_test_missing", 1),
+              StatusIs(absl::StatusCode::kUnavailable));
+}
+
+}  // namespace
+}  // namespace aruco
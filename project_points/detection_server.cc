@@ -0,0 +1,113 @@
+#include "project_points/detection_server.h"
+#include <thread>
+#include "absl/strings/str_cat.h"
+
+namespace aruco {
+
+absl::StatusOr<std::unique_ptr<DetectionServer>> DetectionServer::Create(
+    const IntrinsicCalibration& calibration, const Context& context,
+    const DetectionServerOptions& options) {
+  if (options.max_clients <= 0) {
+    return absl::InvalidArgumentError("max_clients must be positive");
+  }
+  if (context.item_points.size() > static_cast<size_t>(kMaxShmItems)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("At most ", kMaxShmItems, " item points are supported"));
+  }
+  std::unique_ptr<DetectionServer> server(new DetectionServer());
+  server->calibration_ = calibration;
+  server->context_ = context;
+  server->detector_params_ = options.detector_params;
+  for (int32_t i = 0; i < options.max_clients; ++i) {
+    auto channel =
+        ShmChannel::Create(ShmChannelName(options.channel_prefix, i),
+                           options.slot_count, options.max_frame_bytes);
+    if (!channel.ok()) return channel.status();
+    server->channels_.push_back(*std::move(channel));
+  }
+  return server;
+}
+
+void DetectionServer::Run(const std::atomic<bool>& stop) {
+  std::vector<std::thread> threads;
+  for (const auto& channel : channels_) {
+    threads.emplace_back(
+        [this, &channel, &stop]() { Serve(*channel, stop); });
+  }
+  for (std::thread& thread : threads) thread.join();
+}
+
+void DetectionServer::Serve(const ShmChannel& channel,
+                            const std::atomic<bool>& stop) const {
+  // Detector per thread, it is cheap and nothing is shared.
+  const cv::aruco::ArucoDetector detector(
+      cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250),
+      detector_params_);
+  ShmChannelHeader& header = channel.header();
+  const uint32_t slot_count = channel.slot_count();
+  Backoff backoff;
+  while (!stop.load(std::memory_order_relaxed)) {
+    const uint64_t tail = header.request_tail.load(std::memory_order_relaxed);
+    if (tail == header.request_head.load(std::memory_order_acquire)) {
+      backoff.Wait();
+      continue;
+    }
+    backoff.Reset();
+
+    // Wait for the client to make room for the result.
+    const uint64_t result_head =
+        header.result_head.load(std::memory_order_relaxed);
+    while (result_head - header.result_tail.load(std::memory_order_acquire) >=
+           slot_count) {
+      if (stop.load(std::memory_order_relaxed)) return;
+      backoff.Wait();
+    }
+    backoff.Reset();
+
+    ProcessFrame(channel, tail, detector, channel.result_slot(result_head));
+    header.result_head.store(result_head + 1, std::memory_order_release);
+    header.request_tail.store(tail + 1, std::memory_order_release);
+  }
+}
+
+void DetectionServer::ProcessFrame(const ShmChannel& channel,
+                                   uint64_t sequence,
+                                   const cv::aruco::ArucoDetector& detector,
+                                   ShmResultSlot& result) const {
+  const int64_t start_ns = MonotonicNowNs();
+  const ShmFrameSlot& slot = channel.frame_slot(sequence);
+  result.sequence = slot.sequence;
+  result.submit_ns = slot.submit_ns;
+  result.markers.clear();
+  result.item_count = 0;
+
+  const int32_t channels = CV_MAT_CN(slot.type);
+  if (slot.rows <= 0 || slot.cols <= 0 || CV_MAT_DEPTH(slot.type) != CV_8U ||
+      (channels != 1 && channels != 3) ||
+      slot.step < static_cast<uint64_t>(slot.cols) * channels ||
+      // Divided, a step from shared memory may overflow the product.
+      slot.step > channel.max_frame_bytes() / slot.rows) {
+    result.status_code =
+        static_cast<int32_t>(absl::StatusCode::kInvalidArgument);
+    result.processing_ns = MonotonicNowNs() - start_ns;
+    return;
+  }
+
+  // Frame stays in shared memory, no copy.
+  const cv::Mat frame(slot.rows, slot.cols, slot.type,
+                      channel.frame_data(sequence), slot.step);
+  result.markers = DetectArucoPoints(frame, detector);
+  auto item_points = ProjectItemPoints(calibration_, context_, result.markers);
+  result.status_code = static_cast<int32_t>(item_points.status().code());
+  if (item_points.ok()) {
+    for (size_t i = 0; i < item_points->size(); ++i) {
+      result.items[result.item_count++] =
+          ShmPoint{.id = context_.item_points[i].id,
+                   .x = item_points->at(i).x,
+                   .y = item_points->at(i).y};
+    }
+  }
+  result.processing_ns = MonotonicNowNs() - start_ns;
+}
+
+}  // namespace aruco
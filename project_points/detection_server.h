@@ -0,0 +1,54 @@
+// Resident detection service. Loads calibration and context once and serves
+// clients over shared memory channels, see shm_channel.h.
+#ifndef DETECTION_SERVER_H
+#define DETECTION_SERVER_H
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "absl/status/statusor.h"
+#include "project_points/projection.h"
+#include "project_points/shm_channel.h"
+
+namespace aruco {
+
+inline constexpr absl::string_view kDefaultDetectionChannelPrefix =
+    "/aruco_detection";
+
+struct DetectionServerOptions {
+  // Channels are named <prefix>.0 .. <prefix>.<max_clients - 1>.
+  std::string channel_prefix = std::string(kDefaultDetectionChannelPrefix);
+  int32_t max_clients = 4;
+  // Frames in flight per client.
+  uint32_t slot_count = 4;
+  // Largest frame a client can submit. Default fits 4K BGR.
+  uint64_t max_frame_bytes = 3840ull * 2160 * 3;
+  // E.g. tuned with tune_detector_main.
+  cv::aruco::DetectorParameters detector_params;
+};
+
+class DetectionServer {
+ public:
+  static absl::StatusOr<std::unique_ptr<DetectionServer>> Create(
+      const IntrinsicCalibration& calibration, const Context& context,
+      const DetectionServerOptions& options);
+
+  // Serves every channel on its own thread until stop is set.
+  void Run(const std::atomic<bool>& stop);
+
+ private:
+  DetectionServer() = default;
+  void Serve(const ShmChannel& channel, const std::atomic<bool>& stop) const;
+  void ProcessFrame(const ShmChannel& channel, uint64_t sequence,
+                    const cv::aruco::ArucoDetector& detector,
+                    ShmResultSlot& result) const;
+
+  IntrinsicCalibration calibration_;
+  Context context_;
+  cv::aruco::DetectorParameters detector_params_;
+  std::vector<std::unique_ptr<ShmChannel>> channels_;
+};
+
+}  // namespace aruco
+
+#endif  // DETECTION_SERVER_H
@@ -0,0 +1,141 @@
+#include "project_points/detector_tuning.h"
+#include <algorithm>
+#include <limits>
+#include "absl/strings/str_format.h"
+#include "project_points/projection.h"
+
+namespace aruco {
+namespace {
+
+const char* CornerRefinementName(int method) {
+  switch (method) {
+    case cv::aruco::CORNER_REFINE_NONE:
+      return "none";
+    case cv::aruco::CORNER_REFINE_SUBPIX:
+      return "subpix";
+    case cv::aruco::CORNER_REFINE_CONTOUR:
+      return "contour";
+    case cv::aruco::CORNER_REFINE_APRILTAG:
+      return "apriltag";
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+DetectorSearchSpace DefaultSearchSpace() {
+  DetectorSearchSpace space;
+  // OpenCV default first, then fewer and single windows. A single window
+  // around the marker border width is usually enough for a fixed setup.
+  space.threshold_windows = {{3, 23, 10}, {3, 13, 10}, {5, 15, 5},
+                             {7, 17, 10}, {7, 7, 10},  {11, 11, 10},
+                             {13, 13, 10}, {15, 15, 10}, {19, 19, 10},
+                             {23, 23, 10}, {7, 23, 8},  {11, 21, 10}};
+  space.min_marker_perimeter_rates = {0.03, 0.06, 0.1};
+  space.max_marker_perimeter_rates = {4.0, 1.0};
+  space.polygonal_approx_accuracy_rates = {0.03, 0.05};
+  space.corner_refinement_methods = {cv::aruco::CORNER_REFINE_NONE,
+                                     cv::aruco::CORNER_REFINE_SUBPIX,
+                                     cv::aruco::CORNER_REFINE_CONTOUR};
+  return space;
+}
+
+std::vector<cv::aruco::DetectorParameters> EnumerateCandidates(
+    const DetectorSearchSpace& space,
+    const cv::aruco::DetectorParameters& base) {
+  std::vector<cv::aruco::DetectorParameters> candidates;
+  for (const ThresholdWindows& windows : space.threshold_windows) {
+    for (double min_rate : space.min_marker_perimeter_rates) {
+      for (double max_rate : space.max_marker_perimeter_rates) {
+        for (double accuracy : space.polygonal_approx_accuracy_rates) {
+          for (cv::aruco::CornerRefineMethod method :
+               space.corner_refinement_methods) {
+            cv::aruco::DetectorParameters params = base;
+            params.adaptiveThreshWinSizeMin = windows.min;
+            params.adaptiveThreshWinSizeMax = windows.max;
+            params.adaptiveThreshWinSizeStep = windows.step;
+            params.minMarkerPerimeterRate = min_rate;
+            params.maxMarkerPerimeterRate = max_rate;
+            params.polygonalApproxAccuracyRate = accuracy;
+            params.cornerRefinementMethod = method;
+            candidates.push_back(params);
+          }
+        }
+      }
+    }
+  }
+  return candidates;
+}
+
+CandidateScore ScoreCandidate(const cv::aruco::DetectorParameters& params,
+                              const cv::aruco::Dictionary& dictionary,
+                              const std::vector<LabeledImage>& images,
+                              const TuningOptions& options) {
+  const cv::aruco::ArucoDetector detector(dictionary, params);
+  CandidateScore score;
+  for (const LabeledImage& image : images) {
+    score.expected_markers += static_cast<int32_t>(image.ids.size());
+  }
+  for (const LabeledImage& image : images) {
+    DetectedMarkers markers;
+    double best_ms = std::numeric_limits<double>::max();
+    for (int32_t i = 0; i < std::max(1, options.repetitions); ++i) {
+      const int64_t start_ticks = cv::getTickCount();
+      markers = DetectArucoPoints(image.image, detector);
+      best_ms = std::min(best_ms, (cv::getTickCount() - start_ticks) /
+                                      cv::getTickFrequency() * 1000.0);
+    }
+    score.total_ms += best_ms;
+
+    bool missed = false;
+    for (size_t i = 0; i < image.ids.size(); ++i) {
+      const DetectedMarker* marker = markers.Find(image.ids[i]);
+      const bool found =
+          marker != nullptr &&
+          (image.centers.empty() ||
+           cv::norm(marker->center - image.centers[i]) <=
+               options.max_center_error_px);
+      if (found) {
+        ++score.found_markers;
+      } else {
+        missed = true;
+      }
+    }
+    if (missed && options.stop_at_first_miss) {
+      // The candidate is out, remaining images are not worth the time.
+      score.total_ms = std::numeric_limits<double>::infinity();
+      break;
+    }
+  }
+  return score;
+}
+
+std::vector<CandidateScore> ScoreCandidates(
+    const std::vector<cv::aruco::DetectorParameters>& candidates,
+    const cv::aruco::Dictionary& dictionary,
+    const std::vector<LabeledImage>& images, const TuningOptions& options) {
+  std::vector<CandidateScore> scores(candidates.size());
+  cv::parallel_for_(
+      cv::Range(0, static_cast<int32_t>(candidates.size())),
+      [&](const cv::Range& range) {
+        for (int32_t i = range.start; i < range.end; ++i) {
+          scores[i] =
+              ScoreCandidate(candidates[i], dictionary, images, options);
+        }
+      },
+      /*nstripes=*/static_cast<double>(candidates.size()));
+  return scores;
+}
+
+std::string DescribeDetectorParameters(
+    const cv::aruco::DetectorParameters& params) {
+  return absl::StrFormat(
+      "threshold windows %d-%d step %d, perimeter rate %.2f-%.2f, polygon "
+      "accuracy %.2f, corner refinement %s",
+      params.adaptiveThreshWinSizeMin, params.adaptiveThreshWinSizeMax,
+      params.adaptiveThreshWinSizeStep, params.minMarkerPerimeterRate,
+      params.maxMarkerPerimeterRate, params.polygonalApproxAccuracyRate,
+      CornerRefinementName(params.cornerRefinementMethod));
+}
+
+}  // namespace aruco
@@ -0,0 +1,85 @@
+// Searches DetectorParameters for the fastest configuration that still finds
+// every labeled marker. Candidates are scored in parallel, one candidate per
+// task. Detection inside a task then runs single threaded, which keeps the
+// timings comparable between candidates.
+#ifndef DETECTOR_TUNING_H
+#define DETECTOR_TUNING_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "opencv2/core.hpp"
+#include "opencv2/objdetect/aruco_detector.hpp"
+#include "opencv2/objdetect/aruco_dictionary.hpp"
+
+namespace aruco {
+
+struct LabeledImage {
+  std::string path;
+  // Grayscale, detection would convert color frames anyway.
+  cv::Mat image;
+  // Marker ids that must be detected.
+  std::vector<int32_t> ids;
+  // Marker centers in the order of ids, empty if only ids are known.
+  std::vector<cv::Point2f> centers;
+};
+
+struct ThresholdWindows {
+  int32_t min = 3;
+  int32_t max = 23;
+  int32_t step = 10;
+};
+
+// Values tried per parameter, candidates are all combinations.
+struct DetectorSearchSpace {
+  std::vector<ThresholdWindows> threshold_windows;
+  std::vector<double> min_marker_perimeter_rates;
+  std::vector<double> max_marker_perimeter_rates;
+  std::vector<double> polygonal_approx_accuracy_rates;
+  std::vector<cv::aruco::CornerRefineMethod> corner_refinement_methods;
+};
+
+DetectorSearchSpace DefaultSearchSpace();
+
+// Every combination of the search space applied on top of base.
+std::vector<cv::aruco::DetectorParameters> EnumerateCandidates(
+    const DetectorSearchSpace& space,
+    const cv::aruco::DetectorParameters& base);
+
+struct TuningOptions {
+  // A labeled marker only counts as found within this distance of its
+  // labeled center.
+  double max_center_error_px = 2.0;
+  // Detection time per image is the best of this many runs.
+  int32_t repetitions = 1;
+  // Stops scoring a candidate at its first missed marker.
+  bool stop_at_first_miss = true;
+};
+
+struct CandidateScore {
+  int32_t expected_markers = 0;
+  int32_t found_markers = 0;
+  // Detection time summed over the images.
+  double total_ms = 0;
+
+  bool full_recall() const { return found_markers == expected_markers; }
+};
+
+// Detects markers on every image with params.
+CandidateScore ScoreCandidate(const cv::aruco::DetectorParameters& params,
+                              const cv::aruco::Dictionary& dictionary,
+                              const std::vector<LabeledImage>& images,
+                              const TuningOptions& options);
+
+// Scores all candidates in parallel, scores are indexed like candidates.
+std::vector<CandidateScore> ScoreCandidates(
+    const std::vector<cv::aruco::DetectorParameters>& candidates,
+    const cv::aruco::Dictionary& dictionary,
+    const std::vector<LabeledImage>& images, const TuningOptions& options);
+
+// Human readable summary of the tuned fields for logs.
+std::string DescribeDetectorParameters(
+    const cv::aruco::DetectorParameters& params);
+
+}  // namespace aruco
+
+#endif  // DETECTOR_TUNING_H
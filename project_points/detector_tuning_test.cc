@@ -0,0 +1,98 @@
+#include "project_points/detector_tuning.h"
+#include <cmath>
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+
+namespace aruco {
+namespace {
+
+const cv::aruco::Dictionary& Dictionary() {
+  static const cv::aruco::Dictionary* const dictionary =
+      new cv::aruco::Dictionary(
+          cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250));
+  return *dictionary;
+}
+
+// Markers 1..4 of 120 px on a white frame.
+LabeledImage MarkerImage() {
+  LabeledImage labeled;
+  labeled.path = "synthetic";
+  labeled.image = cv::Mat(720, 1280, CV_8UC1, cv::Scalar(255));
+  const std::vector<cv::Point> origins = {
+      {100, 100}, {1000, 120}, {980, 500}, {140, 480}};
+  for (size_t i = 0; i < origins.size(); ++i) {
+    cv::Mat marker;
+    cv::aruco::generateImageMarker(Dictionary(), static_cast<int>(i + 1), 120,
+                                   marker, 1);
+    marker.copyTo(labeled.image(cv::Rect(origins[i], cv::Size(120, 120))));
+    labeled.ids.push_back(static_cast<int32_t>(i + 1));
+    labeled.centers.push_back(cv::Point2f(origins[i]) +
+                              cv::Point2f(59.5, 59.5));
+  }
+  return labeled;
+}
+
+TEST(DetectorTuning, EnumeratesAllCombinations) {
+  const DetectorSearchSpace space = DefaultSearchSpace();
+  const std::vector<cv::aruco::DetectorParameters> candidates =
+      EnumerateCandidates(space, cv::aruco::DetectorParameters());
+  EXPECT_THAT(candidates,
+              testing::SizeIs(space.threshold_windows.size() *
+                              space.min_marker_perimeter_rates.size() *
+                              space.max_marker_perimeter_rates.size() *
+                              space.polygonal_approx_accuracy_rates.size() *
+                              space.corner_refinement_methods.size()));
+  EXPECT_EQ(candidates.front().adaptiveThreshWinSizeMin,
+            space.threshold_windows.front().min);
+  EXPECT_EQ(candidates.back().cornerRefinementMethod,
+            space.corner_refinement_methods.back());
+}
+
+TEST(DetectorTuning, DefaultsFindAllMarkers) {
+  const CandidateScore score =
+      ScoreCandidate(cv::aruco::DetectorParameters(), Dictionary(),
+                     {MarkerImage(), MarkerImage()}, TuningOptions());
+  EXPECT_EQ(score.expected_markers, 8);
+  EXPECT_EQ(score.found_markers, 8);
+  EXPECT_TRUE(score.full_recall());
+  EXPECT_GT(score.total_ms, 0);
+  EXPECT_TRUE(std::isfinite(score.total_ms));
+}
+
+TEST(DetectorTuning, MissedMarkersFailRecall) {
+  // 120 px markers have a perimeter rate of 0.375, the candidate skips them.
+  cv::aruco::DetectorParameters params;
+  params.minMarkerPerimeterRate = 0.5;
+  const CandidateScore score = ScoreCandidate(
+      params, Dictionary(), {MarkerImage(), MarkerImage()}, TuningOptions());
+  EXPECT_FALSE(score.full_recall());
+  EXPECT_EQ(score.found_markers, 0);
+  EXPECT_TRUE(std::isinf(score.total_ms));
+}
+
+TEST(DetectorTuning, CentersMustMatchLabels) {
+  LabeledImage image = MarkerImage();
+  image.centers[2] += cv::Point2f(5, 0);
+  TuningOptions options;
+  options.stop_at_first_miss = false;
+  const CandidateScore score = ScoreCandidate(
+      cv::aruco::DetectorParameters(), Dictionary(), {image}, options);
+  EXPECT_EQ(score.found_markers, 3);
+  EXPECT_TRUE(std::isfinite(score.total_ms));
+}
+
+TEST(DetectorTuning, ScoresCandidatesInParallel) {
+  cv::aruco::DetectorParameters blind;
+  blind.minMarkerPerimeterRate = 0.5;
+  const std::vector<cv::aruco::DetectorParameters> candidates = {
+      cv::aruco::DetectorParameters(), blind, cv::aruco::DetectorParameters()};
+  const std::vector<CandidateScore> scores = ScoreCandidates(
+      candidates, Dictionary(), {MarkerImage()}, TuningOptions());
+  ASSERT_THAT(scores, testing::SizeIs(3));
+  EXPECT_TRUE(scores[0].full_recall());
+  EXPECT_FALSE(scores[1].full_recall());
+  EXPECT_TRUE(scores[2].full_recall());
+}
+
+}  // namespace
+}  // namespace aruco
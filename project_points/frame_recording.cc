@@ -0,0 +1,296 @@
+#include "project_points/frame_recording.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "absl/strings/str_cat.h"
+
+namespace aruco {
+namespace {
+
+constexpr char kFileMagic[8] = {'A', 'R', 'U', 'C', 'O', 'R', 'E', 'C'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kChunkMagic = 0x4b4e4843;  // "CHNK"
+constexpr uint64_t kAlignment = 64;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct ChunkHeader {
+  uint32_t magic;
+  uint32_t frame_count;
+  // Size of the whole chunk including this header.
+  uint64_t size;
+};
+
+struct FrameHeader {
+  int64_t timestamp_ns;
+  int32_t rows;
+  int32_t cols;
+  int32_t type;
+  uint32_t reserved;
+  // Offset of pixel data from the start of the file.
+  uint64_t offset;
+};
+
+static_assert(sizeof(FileHeader) == 16);
+static_assert(sizeof(ChunkHeader) == 16);
+static_assert(sizeof(FrameHeader) == 32);
+
+uint64_t Align(uint64_t value) {
+  return (value + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+uint64_t FrameBytes(int32_t rows, int32_t cols, int32_t type) {
+  return static_cast<uint64_t>(rows) * cols * CV_ELEM_SIZE(type);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<FrameRecorder>> FrameRecorder::Create(
+    absl::string_view path, int32_t frames_per_chunk) {
+  if (frames_per_chunk <= 0) {
+    return absl::InvalidArgumentError("frames_per_chunk must be positive");
+  }
+  std::unique_ptr<FrameRecorder> recorder(new FrameRecorder());
+  recorder->frames_per_chunk_ = frames_per_chunk;
+  recorder->file_.open(std::string(path),
+                       std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!recorder->file_) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Failed to open recording: ", path));
+  }
+  FileHeader header{};
+  std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.version = kVersion;
+  recorder->file_.write(reinterpret_cast<const char*>(&header),
+                        sizeof(header));
+  if (!recorder->file_) {
+    return absl::InternalError(absl::StrCat("Failed writing to ", path));
+  }
+  return recorder;
+}
+
+FrameRecorder::~FrameRecorder() {
+  if (file_.is_open()) Close().IgnoreError();
+}
+
+absl::Status FrameRecorder::Write(const cv::Mat& frame, int64_t timestamp_ns) {
+  if (!file_.is_open()) return absl::FailedPreconditionError("Closed");
+  if (frame.empty() || frame.dims != 2) {
+    return absl::InvalidArgumentError("Frame must be a non-empty 2D image");
+  }
+  // Capture usually reuses its buffer, so keep a copy until the chunk is out.
+  frames_.push_back(frame.clone());
+  timestamps_.push_back(timestamp_ns);
+  ++frame_count_;
+  if (static_cast<int32_t>(frames_.size()) >= frames_per_chunk_) {
+    return FlushChunk();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FrameRecorder::Close() {
+  if (!file_.is_open()) return absl::OkStatus();
+  absl::Status status = FlushChunk();
+  file_.close();
+  return status;
+}
+
+absl::Status FrameRecorder::FlushChunk() {
+  if (frames_.empty()) return absl::OkStatus();
+
+  const uint64_t chunk_start = static_cast<uint64_t>(file_.tellp());
+  uint64_t offset = chunk_start + sizeof(ChunkHeader) +
+                    frames_.size() * sizeof(FrameHeader);
+  std::vector<FrameHeader> headers;
+  for (size_t i = 0; i < frames_.size(); ++i) {
+    offset = Align(offset);
+    headers.push_back(FrameHeader{.timestamp_ns = timestamps_[i],
+                                  .rows = frames_[i].rows,
+                                  .cols = frames_[i].cols,
+                                  .type = frames_[i].type(),
+                                  .reserved = 0,
+                                  .offset = offset});
+    offset += FrameBytes(frames_[i].rows, frames_[i].cols, frames_[i].type());
+  }
+  const ChunkHeader chunk{.magic = kChunkMagic,
+                          .frame_count = static_cast<uint32_t>(frames_.size()),
+                          .size = offset - chunk_start};
+
+  file_.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+  file_.write(reinterpret_cast<const char*>(headers.data()),
+              headers.size() * sizeof(FrameHeader));
+  uint64_t position =
+      chunk_start + sizeof(ChunkHeader) + headers.size() * sizeof(FrameHeader);
+  static constexpr char kPadding[kAlignment] = {};
+  for (size_t i = 0; i < frames_.size(); ++i) {
+    file_.write(kPadding, headers[i].offset - position);
+    // Clones are continuous.
+    const uint64_t bytes =
+        FrameBytes(headers[i].rows, headers[i].cols, headers[i].type);
+    file_.write(reinterpret_cast<const char*>(frames_[i].data), bytes);
+    position = headers[i].offset + bytes;
+  }
+  file_.flush();
+  frames_.clear();
+  timestamps_.clear();
+  if (!file_) return absl::InternalError("Failed writing recording chunk");
+  return absl::OkStatus();
+}
+
+ReplayCapture::ReplayCapture(Pacing pacing) : pacing_(pacing) {}
+
+ReplayCapture::ReplayCapture(const std::string& path, Pacing pacing)
+    : pacing_(pacing) {
+  open(path);
+}
+
+ReplayCapture::~ReplayCapture() { release(); }
+
+bool ReplayCapture::open(const cv::String& path, int api_preference) {
+  release();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0 ||
+      file_stat.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+    ::close(fd);
+    return false;
+  }
+  const size_t size = static_cast<size_t>(file_stat.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) return false;
+  data_ = static_cast<uint8_t*>(data);
+  size_ = size;
+
+  FileHeader header;
+  std::memcpy(&header, data_, sizeof(header));
+  if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header.version != kVersion) {
+    release();
+    return false;
+  }
+
+  // Index all complete chunks. Anything after the last complete chunk is a
+  // recording cut short and is ignored.
+  uint64_t position = sizeof(FileHeader);
+  while (position + sizeof(ChunkHeader) <= size_) {
+    ChunkHeader chunk;
+    std::memcpy(&chunk, data_ + position, sizeof(chunk));
+    if (chunk.magic != kChunkMagic || chunk.size > size_ - position ||
+        sizeof(ChunkHeader) + chunk.frame_count * sizeof(FrameHeader) >
+            chunk.size) {
+      break;
+    }
+    const uint64_t chunk_end = position + chunk.size;
+    for (uint32_t i = 0; i < chunk.frame_count; ++i) {
+      FrameHeader frame;
+      std::memcpy(&frame,
+                  data_ + position + sizeof(ChunkHeader) +
+                      i * sizeof(FrameHeader),
+                  sizeof(frame));
+      if (frame.offset + FrameBytes(frame.rows, frame.cols, frame.type) >
+          chunk_end) {
+        break;
+      }
+      frames_.push_back(Frame{.timestamp_ns = frame.timestamp_ns,
+                              .rows = frame.rows,
+                              .cols = frame.cols,
+                              .type = frame.type,
+                              .offset = frame.offset});
+    }
+    position = chunk_end;
+  }
+  ::madvise(data_, size_, MADV_SEQUENTIAL);
+  return true;
+}
+
+bool ReplayCapture::isOpened() const { return data_ != nullptr; }
+
+void ReplayCapture::release() {
+  if (data_ != nullptr) ::munmap(data_, size_);
+  data_ = nullptr;
+  size_ = 0;
+  frames_.clear();
+  next_frame_ = 0;
+  started_ = false;
+}
+
+bool ReplayCapture::grab() {
+  if (next_frame_ >= frame_count()) return false;
+  const int64_t timestamp_ns = frames_[next_frame_].timestamp_ns;
+  if (pacing_ == Pacing::kOriginal) {
+    if (!started_) {
+      start_ = std::chrono::steady_clock::now();
+      start_timestamp_ns_ = timestamp_ns;
+      started_ = true;
+    } else {
+      std::this_thread::sleep_until(
+          start_ + std::chrono::nanoseconds(timestamp_ns - start_timestamp_ns_));
+    }
+  }
+  ++next_frame_;
+  return true;
+}
+
+bool ReplayCapture::retrieve(cv::OutputArray image, int flag) {
+  if (next_frame_ == 0) return false;
+  const Frame& frame = frames_[next_frame_ - 1];
+  // Copied, the mapping is read only and frames are drawn on.
+  cv::Mat(frame.rows, frame.cols, frame.type, data_ + frame.offset)
+      .copyTo(image);
+  return true;
+}
+
+bool ReplayCapture::read(cv::OutputArray image) {
+  if (grab()) return retrieve(image);
+  image.release();
+  return false;
+}
+
+double ReplayCapture::get(int prop_id) const {
+  if (frames_.empty()) return 0;
+  switch (prop_id) {
+    case cv::CAP_PROP_FRAME_WIDTH:
+      return frames_.front().cols;
+    case cv::CAP_PROP_FRAME_HEIGHT:
+      return frames_.front().rows;
+    case cv::CAP_PROP_FRAME_COUNT:
+      return static_cast<double>(frames_.size());
+    case cv::CAP_PROP_FPS: {
+      const int64_t duration_ns =
+          frames_.back().timestamp_ns - frames_.front().timestamp_ns;
+      if (duration_ns <= 0) return 0;
+      return (frames_.size() - 1) * 1e9 / duration_ns;
+    }
+    case cv::CAP_PROP_POS_FRAMES:
+      return static_cast<double>(next_frame_);
+    case cv::CAP_PROP_POS_MSEC:
+      return (timestamp_ns() - frames_.front().timestamp_ns) / 1e6;
+    default:
+      return 0;
+  }
+}
+
+bool ReplayCapture::set(int prop_id, double value) {
+  if (prop_id != cv::CAP_PROP_POS_FRAMES) return false;
+  next_frame_ = std::clamp<int64_t>(static_cast<int64_t>(value), 0,
+                                    frame_count());
+  started_ = false;
+  return true;
+}
+
+int64_t ReplayCapture::timestamp_ns() const {
+  if (next_frame_ == 0) return frames_.empty() ? 0 : frames_[0].timestamp_ns;
+  return frames_[next_frame_ - 1].timestamp_ns;
+}
+
+}  // namespace aruco
@@ -0,0 +1,113 @@
+// Record and replay of raw camera frames for reproducible performance runs.
+//
+// File layout, all integers little endian:
+//   FileHeader
+//   Chunk*
+// where every chunk is
+//   ChunkHeader, FrameHeader[frame_count], pixel data
+// Pixel data of every frame is 64 byte aligned relative to the file start so
+// replayed frames can point straight into the memory map. A chunk is written
+// in one go, so a recording cut short by a crash loses at most the last
+// chunk.
+#ifndef FRAME_RECORDING_H
+#define FRAME_RECORDING_H
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "opencv2/videoio.hpp"
+
+namespace aruco {
+
+class FrameRecorder {
+ public:
+  static absl::StatusOr<std::unique_ptr<FrameRecorder>> Create(
+      absl::string_view path, int32_t frames_per_chunk = 16);
+  // Writes pending frames.
+  ~FrameRecorder();
+
+  // Appends the frame. Timestamp is capture time in nanoseconds in any
+  // monotonic clock, replay only uses differences.
+  absl::Status Write(const cv::Mat& frame, int64_t timestamp_ns);
+
+  // Writes pending frames and closes the file.
+  absl::Status Close();
+
+  int64_t frame_count() const { return frame_count_; }
+
+ private:
+  FrameRecorder() = default;
+  absl::Status FlushChunk();
+
+  std::ofstream file_;
+  int32_t frames_per_chunk_ = 0;
+  int64_t frame_count_ = 0;
+  // Pending chunk
+  std::vector<cv::Mat> frames_;
+  std::vector<int64_t> timestamps_;
+};
+
+// Replays a recording as cv::VideoCapture, so it can be passed wherever a
+// capture is accepted. The recording is memory mapped read only and every
+// frame is copied out, into the caller's image when its size and type match,
+// so drawing onto frames does not change what a later replay returns.
+class ReplayCapture : public cv::VideoCapture {
+ public:
+  enum class Pacing {
+    // Sleeps to reproduce the original capture cadence.
+    kOriginal,
+    // Returns frames as fast as they are read.
+    kAsFastAsPossible,
+  };
+
+  explicit ReplayCapture(Pacing pacing = Pacing::kOriginal);
+  ReplayCapture(const std::string& path, Pacing pacing);
+  ReplayCapture(const ReplayCapture&) = delete;
+  ReplayCapture& operator=(const ReplayCapture&) = delete;
+  ~ReplayCapture() override;
+
+  using cv::VideoCapture::open;
+  bool open(const cv::String& path, int api_preference = cv::CAP_ANY) override;
+  bool isOpened() const override;
+  void release() override;
+  bool grab() override;
+  bool retrieve(cv::OutputArray image, int flag = 0) override;
+  bool read(cv::OutputArray image) override;
+  // Supports frame size, FPS, frame count, position in frames and ms.
+  double get(int prop_id) const override;
+  // Supports seeking with CAP_PROP_POS_FRAMES.
+  bool set(int prop_id, double value) override;
+
+  // Capture timestamp of the last grabbed frame.
+  int64_t timestamp_ns() const;
+  int64_t frame_count() const { return static_cast<int64_t>(frames_.size()); }
+
+ private:
+  struct Frame {
+    int64_t timestamp_ns;
+    int32_t rows;
+    int32_t cols;
+    int32_t type;
+    uint64_t offset;
+  };
+
+  Pacing pacing_;
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  std::vector<Frame> frames_;
+  // Index of the frame returned by the next grab.
+  int64_t next_frame_ = 0;
+  // Wall time of replay start shifted to the timestamp of the first frame
+  // played since the last seek.
+  std::chrono::steady_clock::time_point start_;
+  int64_t start_timestamp_ns_ = 0;
+  bool started_ = false;
+};
+
+}  // namespace aruco
+
+#endif  // FRAME_RECORDING_H
@@ -0,0 +1,116 @@
+#include "project_points/frame_recording.h"
+#include <cstdlib>
+#include <filesystem>
+#include "absl/status/status_matchers.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+
+namespace aruco {
+namespace {
+
+using ::absl_testing::IsOk;
+
+std::string TempPath(absl::string_view name) {
+  return (std::filesystem::path(std::getenv("TEST_TMPDIR")) / name).string();
+}
+
+std::vector<cv::Mat> MakeFrames() {
+  std::vector<cv::Mat> frames;
+  for (int32_t i = 0; i < 5; ++i) {
+    cv::Mat frame(48 + i, 64, CV_8UC3);
+    cv::randu(frame, 0, 255);
+    frames.push_back(frame);
+  }
+  // Non-continuous ROI and a different type
+  frames.push_back(frames[0](cv::Rect(3, 5, 17, 11)));
+  frames.push_back(cv::Mat(10, 10, CV_16UC1, cv::Scalar(1000)));
+  return frames;
+}
+
+TEST(FrameRecording, RoundTrip) {
+  const std::string path = TempPath("round_trip.frames");
+  const std::vector<cv::Mat> frames = MakeFrames();
+  {
+    auto recorder = FrameRecorder::Create(path, /*frames_per_chunk=*/3);
+    ASSERT_THAT(recorder, IsOk());
+    for (int64_t i = 0; i < static_cast<int64_t>(frames.size()); ++i) {
+      ASSERT_THAT((*recorder)->Write(frames[i], 1'000'000'000 + i * 33'000'000),
+                  IsOk());
+    }
+    ASSERT_THAT((*recorder)->Close(), IsOk());
+  }
+
+  ReplayCapture replay(path, ReplayCapture::Pacing::kAsFastAsPossible);
+  ASSERT_TRUE(replay.isOpened());
+  EXPECT_EQ(replay.frame_count(), static_cast<int64_t>(frames.size()));
+  EXPECT_EQ(replay.get(cv::CAP_PROP_FRAME_WIDTH), 64);
+  EXPECT_EQ(replay.get(cv::CAP_PROP_FRAME_HEIGHT), 48);
+  EXPECT_NEAR(replay.get(cv::CAP_PROP_FPS), 1000.0 / 33, 0.01);
+
+  cv::Mat frame;
+  for (int64_t i = 0; i < static_cast<int64_t>(frames.size()); ++i) {
+    ASSERT_TRUE(replay.read(frame)) << i;
+    EXPECT_EQ(frame.type(), frames[i].type());
+    EXPECT_EQ(frame.size(), frames[i].size());
+    EXPECT_EQ(cv::norm(frame, frames[i], cv::NORM_INF), 0) << i;
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(frame.data) % 64, 0);
+    EXPECT_EQ(replay.timestamp_ns(), 1'000'000'000 + i * 33'000'000);
+  }
+  EXPECT_FALSE(replay.read(frame));
+  EXPECT_TRUE(frame.empty());
+}
+
+TEST(FrameRecording, ReplayWorksAsVideoCapture) {
+  const std::string path = TempPath("as_capture.frames");
+  const std::vector<cv::Mat> frames = MakeFrames();
+  {
+    auto recorder = FrameRecorder::Create(path);
+    ASSERT_THAT(recorder, IsOk());
+    ASSERT_THAT((*recorder)->Write(frames[0], 0), IsOk());
+    ASSERT_THAT((*recorder)->Write(frames[1], 10'000'000), IsOk());
+  }
+
+  std::unique_ptr<cv::VideoCapture> capture =
+      std::make_unique<ReplayCapture>(path, ReplayCapture::Pacing::kOriginal);
+  ASSERT_TRUE(capture->isOpened());
+  cv::Mat frame;
+  const auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(capture->read(frame));
+  // Drawing on a replayed frame must not touch the recording.
+  frame.setTo(cv::Scalar::all(0));
+  ASSERT_TRUE(capture->read(frame));
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(10));
+  EXPECT_FALSE(capture->read(frame));
+
+  ASSERT_TRUE(capture->set(cv::CAP_PROP_POS_FRAMES, 0));
+  ASSERT_TRUE(capture->read(frame));
+  EXPECT_EQ(cv::norm(frame, frames[0], cv::NORM_INF), 0);
+}
+
+TEST(FrameRecording, IgnoresTruncatedChunk) {
+  const std::string path = TempPath("truncated.frames");
+  const std::vector<cv::Mat> frames = MakeFrames();
+  {
+    auto recorder = FrameRecorder::Create(path, /*frames_per_chunk=*/2);
+    ASSERT_THAT(recorder, IsOk());
+    for (int64_t i = 0; i < 4; ++i) {
+      ASSERT_THAT((*recorder)->Write(frames[i], i), IsOk());
+    }
+  }
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 100);
+
+  ReplayCapture replay(path, ReplayCapture::Pacing::kAsFastAsPossible);
+  ASSERT_TRUE(replay.isOpened());
+  EXPECT_EQ(replay.frame_count(), 2);
+}
+
+TEST(FrameRecording, RejectsOtherFiles) {
+  const std::string path = TempPath("not_a_recording.frames");
+  std::ofstream(path) << "definitely not a recording";
+  ReplayCapture replay(path, ReplayCapture::Pacing::kAsFastAsPossible);
+  EXPECT_FALSE(replay.isOpened());
+}
+
+}  // namespace
+}  // namespace aruco
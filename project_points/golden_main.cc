@@ -0,0 +1,114 @@
+// Regenerates golden results for the regression test. Run it after an
+// intended change of detection or projection output and review the diff.
+// bazel run //project_points:golden_main
+#include <cstdlib>
+#include <filesystem>
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_format.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/objdetect/aruco_detector.hpp"
+#include "opencv2/objdetect/aruco_dictionary.hpp"
+#include "project_points/highgui_utils.h"
+#include "project_points/proto/golden.pb.h"
+#include "project_points/proto_utils.h"
+#include "project_points/regression.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, golden_path, "testdata/golden_results.txtpb",
+          "Golden results text proto relative to the workspace root. Its "
+          "settings, including detector_params_path, are kept, images are "
+          "regenerated.");
+
+ABSL_FLAG(std::string, testdata_dir, "testdata",
+          "Directory scanned recursively for images");
+
+absl::Status Run() {
+  const std::string golden_path = absl::GetFlag(FLAGS_golden_path);
+  aruco::proto::GoldenResults golden;
+  if (auto existing =
+          aruco::LoadFromTextProtoFile<aruco::proto::GoldenResults>(
+              golden_path);
+      existing.ok()) {
+    golden = *std::move(existing);
+  } else {
+    LOG(WARNING) << "Starting from defaults: " << existing.status().message();
+    golden.set_calibration_path("testdata/pixel_6a_calibration.txtpb");
+    golden.set_manifest_path("testdata/simple_manifest.txtpb");
+    golden.set_pixel_tolerance(2.0);
+    golden.set_latency_budget_ms(250);
+    golden.set_latency_repetitions(3);
+  }
+  golden.clear_images();
+
+  ASSIGN_OR_RETURN(
+      auto calibration_proto,
+      aruco::LoadFromTextProtoFile<aruco::proto::IntrinsicCalibration>(
+          golden.calibration_path()));
+  const aruco::IntrinsicCalibration calibration =
+      aruco::ConvertIntrinsicCalibrationFromProto(calibration_proto);
+  ASSIGN_OR_RETURN(auto manifest,
+                   aruco::LoadFromTextProtoFile<aruco::proto::Context>(
+                       golden.manifest_path()));
+  const aruco::Context context = aruco::ConvertContextFromProto(manifest);
+  ASSIGN_OR_RETURN(
+      const cv::aruco::DetectorParameters detector_params,
+      aruco::LoadDetectorParameters(golden.detector_params_path()));
+  const cv::aruco::ArucoDetector detector(
+      cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250),
+      detector_params);
+
+  std::vector<std::string> image_paths;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(
+           absl::GetFlag(FLAGS_testdata_dir),
+           std::filesystem::directory_options::follow_directory_symlink)) {
+    if (aruco::GetFileType(entry.path().string()) == aruco::FileType::kImage) {
+      image_paths.emplace_back(entry.path().string());
+    }
+  }
+  std::sort(image_paths.begin(), image_paths.end());
+
+  for (const std::string& image_path : image_paths) {
+    const cv::Mat image = cv::imread(image_path);
+    if (image.empty()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Failed to load image '%s'", image_path));
+    }
+    const aruco::PipelineResult result = aruco::RunPipeline(
+        image, calibration, context, detector, golden.latency_repetitions());
+    LOG(INFO) << absl::StreamFormat(
+        "%s: %d markers, %d items, %.1f ms, reprojection error %.3f px",
+        image_path, result.marker_points.size(), result.item_points.size(),
+        result.latency_ms, result.reprojection_error_px);
+    *golden.add_images() =
+        aruco::MakeGoldenImage(image_path, result, context);
+  }
+
+  // With bazel run the working directory is the runfiles tree, write into the
+  // source tree instead.
+  std::filesystem::path output_path = golden_path;
+  if (const char* workspace = std::getenv("BUILD_WORKSPACE_DIRECTORY");
+      workspace != nullptr && output_path.is_relative()) {
+    output_path = std::filesystem::path(workspace) / output_path;
+  }
+  RETURN_IF_ERROR(
+      aruco::WriteProtoToTextProto(golden, output_path.string()).status());
+  LOG(INFO) << "Wrote " << golden.images_size() << " images to "
+            << output_path;
+  return absl::OkStatus();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  gflags::SetCommandLineOption("logtostderr", "1");
+  if (const auto status = Run(); !status.ok()) {
+    LOG(ERROR) << "Failed: " << status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -1,6 +1,9 @@
 #include "project_points/highgui_utils.h"
+#include <algorithm>
 #include <filesystem>
 #include <unordered_set>
+#include "opencv2/objdetect/aruco_detector.hpp"
+#include "project_points/trace.h"
 
 namespace aruco {
 
@@ -18,11 +21,15 @@ FileType GetFileType(absl::string_view file_path) {
   static const std::unordered_set<std::string> video_extensions = {
       "mp4", "avi", "mov", "mkv",  "wmv", "flv", "webm",
       "m4v", "3gp", "mpg", "mpeg", "ts",  "mts"};
+  static const std::unordered_set<std::string> recording_extensions = {
+      "frames"};
 
   if (image_extensions.count(extension)) {
     return FileType::kImage;
   } else if (video_extensions.count(extension)) {
     return FileType::kVideo;
+  } else if (recording_extensions.count(extension)) {
+    return FileType::kRecording;
   } else {
     return FileType::kUnknown;
   }
@@ -35,5 +42,65 @@ void DrawCircle(const cv::Mat& image, const cv::Point2f point,
   cv::circle(image, point, radius, color, cv::FILLED);
 }
 
+void DrawOverlay(const cv::Mat& image, const Overlay& overlay, double scale) {
+  if (!overlay.markers.empty()) {
+    std::vector<std::vector<cv::Point2f>> corners;
+    std::vector<int32_t> ids;
+    for (const DetectedMarker& marker : overlay.markers) {
+      std::vector<cv::Point2f>& scaled = corners.emplace_back();
+      for (const cv::Point2f& corner : marker.corners) {
+        scaled.push_back(corner * scale);
+      }
+      ids.push_back(marker.id);
+    }
+    cv::aruco::drawDetectedMarkers(image, corners, ids);
+  }
+  for (const OverlayPoint& point : overlay.points) {
+    DrawCircle(image, point.point * scale, point.color, point.size);
+  }
+}
+
+PreviewWindow::PreviewWindow(absl::string_view name, double max_fps,
+                             cv::Size fallback_size)
+    : name_(name), fallback_size_(fallback_size) {
+  if (max_fps > 0) {
+    min_interval_ticks_ =
+        static_cast<int64_t>(cv::getTickFrequency() / max_fps);
+  }
+  cv::namedWindow(name_, cv::WINDOW_FREERATIO);
+}
+
+bool PreviewWindow::Due() const {
+  return last_shown_ticks_ == 0 ||
+         cv::getTickCount() - last_shown_ticks_ >= min_interval_ticks_;
+}
+
+int PreviewWindow::Show(const cv::Mat& frame, const Overlay& overlay,
+                        bool wait_for_key) {
+  cv::Size window_size = fallback_size_;
+  if (const cv::Rect rect = cv::getWindowImageRect(name_);
+      rect.width > 0 && rect.height > 0) {
+    window_size = rect.size();
+  }
+  const double scale =
+      std::min({1.0, static_cast<double>(window_size.width) / frame.cols,
+                static_cast<double>(window_size.height) / frame.rows});
+  {
+    TraceScope scope("preview_render");
+    if (scale < 1.0) {
+      cv::resize(frame, preview_, cv::Size(), scale, scale, cv::INTER_AREA);
+    } else {
+      frame.copyTo(preview_);
+    }
+    DrawOverlay(preview_, overlay, scale);
+  }
+  {
+    TraceScope scope("imshow");
+    cv::imshow(name_, preview_);
+  }
+  last_shown_ticks_ = cv::getTickCount();
+  TraceScope scope("wait_key");
+  return cv::waitKey(wait_for_key ? 0 : 1);
+}
 
 }  // namespace aruco
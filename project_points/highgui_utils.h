@@ -2,7 +2,10 @@
 #ifndef HIGHGUI_UTILS_H
 #define HIGHGUI_UTILS_H
 #include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
 #include "absl/strings/string_view.h"
+#include "project_points/detected_markers.h"
 
 namespace aruco {
 
@@ -14,7 +17,8 @@ const cv::Scalar kMAGENTA(255, 0, 255);
 const cv::Scalar kCYAN(255, 255, 0);
 const cv::Scalar kORANGE(0, 165, 255);
 
-enum class FileType { kImage, kVideo, kUnknown };
+// kRecording is a raw frame recording made by FrameRecorder.
+enum class FileType { kImage, kVideo, kRecording, kUnknown };
 
 // Given file path returns FileType based on the file path extension.
 FileType GetFileType(absl::string_view file_path);
@@ -24,6 +28,53 @@ FileType GetFileType(absl::string_view file_path);
 void DrawCircle(const cv::Mat& image, const cv::Point2f point,
                 const cv::Scalar& color, int32_t size = 100);
 
+struct OverlayPoint {
+  cv::Point2f point;
+  cv::Scalar color;
+  // Same meaning as DrawCircle size.
+  int32_t size = 100;
+};
+
+// What gets drawn on top of a frame. Coordinates are in full resolution frame
+// pixels, so the same overlay can be drawn onto the frame or its preview.
+struct Overlay {
+  std::vector<OverlayPoint> points;
+  // Detected Aruco markers, outlined with their ids.
+  DetectedMarkers markers;
+};
+
+// Draws overlay onto image which is `scale` times the size of the frame the
+// overlay coordinates belong to.
+void DrawOverlay(const cv::Mat& image, const Overlay& overlay,
+                 double scale = 1.0);
+
+// Shows frames in a window without touching the full resolution frame. The
+// frame is downscaled once to the window size and the overlay is drawn at
+// preview scale. Previews are rate limited independently of processing.
+class PreviewWindow {
+ public:
+  // max_fps <= 0 shows every frame. fallback_size bounds the preview until the
+  // window reports its size.
+  PreviewWindow(absl::string_view name, double max_fps,
+                cv::Size fallback_size = cv::Size(1280, 720));
+
+  // Whether the rate limit allows showing another preview.
+  bool Due() const;
+
+  // Renders and shows the preview. Returns the key pressed meanwhile or -1,
+  // waits for a key press if wait_for_key.
+  int Show(const cv::Mat& frame, const Overlay& overlay,
+           bool wait_for_key = false);
+
+ private:
+  std::string name_;
+  int64_t min_interval_ticks_ = 0;
+  int64_t last_shown_ticks_ = 0;
+  cv::Size fallback_size_;
+  // Reused between previews.
+  cv::Mat preview_;
+};
+
 }  // namespace aruco
 
 #endif  // HIGHGUI_UTILS_H
@@ -0,0 +1,236 @@
+#include "project_points/item_delta_stream.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+#include "absl/strings/str_cat.h"
+
+namespace aruco {
+namespace {
+
+constexpr char kMagic[4] = {'I', 'T', 'M', 'D'};
+constexpr char kVersion = 1;
+constexpr char kSnapshot = 'S';
+constexpr char kDelta = 'D';
+constexpr float kFixedPointScale = 16;
+
+void PutVarint(uint64_t value, std::string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+uint64_t ZigZag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+bool GetVarint(absl::string_view* data, uint64_t* value) {
+  uint64_t result = 0;
+  for (int32_t shift = 0; shift < 64; shift += 7) {
+    if (data->empty()) return false;
+    const uint8_t byte = static_cast<uint8_t>(data->front());
+    data->remove_prefix(1);
+    result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool GetZigZag(absl::string_view* data, int64_t* value) {
+  uint64_t raw;
+  if (!GetVarint(data, &raw)) return false;
+  *value = UnZigZag(raw);
+  return true;
+}
+
+cv::Point ToFixed(const cv::Point2f& point) {
+  return cv::Point(static_cast<int>(std::lround(point.x * kFixedPointScale)),
+                   static_cast<int>(std::lround(point.y * kFixedPointScale)));
+}
+
+cv::Point2f FromFixed(const cv::Point& point) {
+  return cv::Point2f(point.x / kFixedPointScale, point.y / kFixedPointScale);
+}
+
+void PutTag(int32_t id, ItemEvent::Kind kind, std::string* output) {
+  PutVarint(ZigZag(id) << 2 | static_cast<uint64_t>(kind), output);
+}
+
+}  // namespace
+
+ItemDeltaEncoder::ItemDeltaEncoder(float pixel_threshold,
+                                   int32_t snapshot_interval)
+    : pixel_threshold_(pixel_threshold),
+      snapshot_interval_(std::max(1, snapshot_interval)) {}
+
+void ItemDeltaEncoder::Encode(int64_t frame_index,
+                              const std::vector<ItemPosition>& positions,
+                              std::string* output) {
+  if (!header_written_) {
+    output->append(kMagic, sizeof(kMagic));
+    output->push_back(kVersion);
+    header_written_ = true;
+  }
+
+  const bool snapshot = last_snapshot_frame_ < 0 ||
+                        frame_index - last_snapshot_frame_ >= snapshot_interval_;
+  std::string entries;
+  uint64_t count = 0;
+  if (snapshot) {
+    published_.clear();
+    for (const ItemPosition& position : positions) {
+      const cv::Point fixed = ToFixed(position.point);
+      published_[position.id] = fixed;
+      PutVarint(ZigZag(position.id), &entries);
+      PutVarint(ZigZag(fixed.x), &entries);
+      PutVarint(ZigZag(fixed.y), &entries);
+      ++count;
+    }
+    last_snapshot_frame_ = frame_index;
+  } else {
+    std::unordered_set<int32_t> visible;
+    for (const ItemPosition& position : positions) {
+      visible.insert(position.id);
+      const cv::Point fixed = ToFixed(position.point);
+      auto it = published_.find(position.id);
+      if (it == published_.end()) {
+        PutTag(position.id, ItemEvent::Kind::kAppeared, &entries);
+        PutVarint(ZigZag(fixed.x), &entries);
+        PutVarint(ZigZag(fixed.y), &entries);
+        published_[position.id] = fixed;
+        ++count;
+      } else if (cv::norm(position.point - FromFixed(it->second)) >
+                 pixel_threshold_) {
+        PutTag(position.id, ItemEvent::Kind::kMoved, &entries);
+        PutVarint(ZigZag(fixed.x - it->second.x), &entries);
+        PutVarint(ZigZag(fixed.y - it->second.y), &entries);
+        it->second = fixed;
+        ++count;
+      }
+    }
+    std::vector<int32_t> hidden;
+    for (const auto& [id, point] : published_) {
+      if (!visible.contains(id)) hidden.push_back(id);
+    }
+    std::sort(hidden.begin(), hidden.end());
+    for (int32_t id : hidden) {
+      PutTag(id, ItemEvent::Kind::kDisappeared, &entries);
+      published_.erase(id);
+      ++count;
+    }
+    if (count == 0) return;
+  }
+
+  std::string payload;
+  PutVarint(frame_index - last_record_frame_, &payload);
+  PutVarint(count, &payload);
+  payload.append(entries);
+  output->push_back(snapshot ? kSnapshot : kDelta);
+  PutVarint(payload.size(), output);
+  output->append(payload);
+  last_record_frame_ = frame_index;
+}
+
+absl::StatusOr<ItemDeltaRecord> ItemDeltaDecoder::Next(
+    absl::string_view* data) {
+  absl::string_view input = *data;
+  if (!header_read_) {
+    if (input.size() < sizeof(kMagic) + 1) {
+      return absl::OutOfRangeError("Incomplete header");
+    }
+    if (std::memcmp(input.data(), kMagic, sizeof(kMagic)) != 0 ||
+        input[sizeof(kMagic)] != kVersion) {
+      return absl::DataLossError("Not an item delta stream");
+    }
+    input.remove_prefix(sizeof(kMagic) + 1);
+  }
+
+  if (input.empty()) return absl::OutOfRangeError("Incomplete record");
+  const char type = input.front();
+  input.remove_prefix(1);
+  if (type != kSnapshot && type != kDelta) {
+    return absl::DataLossError(absl::StrCat("Unknown record type ", type));
+  }
+  uint64_t size;
+  if (!GetVarint(&input, &size) || input.size() < size) {
+    return absl::OutOfRangeError("Incomplete record");
+  }
+  absl::string_view payload = input.substr(0, size);
+  input.remove_prefix(size);
+
+  ItemDeltaRecord record;
+  record.snapshot = type == kSnapshot;
+  uint64_t frame_increment;
+  uint64_t count;
+  if (!GetVarint(&payload, &frame_increment) ||
+      !GetVarint(&payload, &count)) {
+    return absl::DataLossError("Corrupted record header");
+  }
+  record.frame_index = frame_index_ + static_cast<int64_t>(frame_increment);
+
+  std::unordered_map<int32_t, cv::Point2f> positions;
+  if (!record.snapshot) positions = positions_;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t tag;
+    if (!GetVarint(&payload, &tag)) {
+      return absl::DataLossError("Corrupted entry");
+    }
+    ItemEvent event;
+    int64_t x = 0;
+    int64_t y = 0;
+    if (record.snapshot) {
+      event.kind = ItemEvent::Kind::kAppeared;
+      event.id = static_cast<int32_t>(UnZigZag(tag));
+    } else {
+      event.kind = static_cast<ItemEvent::Kind>(tag & 3);
+      event.id = static_cast<int32_t>(UnZigZag(tag >> 2));
+    }
+    switch (event.kind) {
+      case ItemEvent::Kind::kAppeared:
+        if (!GetZigZag(&payload, &x) || !GetZigZag(&payload, &y)) {
+          return absl::DataLossError("Corrupted position");
+        }
+        event.point = FromFixed(cv::Point(x, y));
+        positions[event.id] = event.point;
+        break;
+      case ItemEvent::Kind::kMoved: {
+        auto it = positions.find(event.id);
+        if (it == positions.end() || !GetZigZag(&payload, &x) ||
+            !GetZigZag(&payload, &y)) {
+          return absl::DataLossError(
+              absl::StrCat("Corrupted move of item ", event.id));
+        }
+        it->second += FromFixed(cv::Point(x, y));
+        event.point = it->second;
+        break;
+      }
+      case ItemEvent::Kind::kDisappeared:
+        if (positions.erase(event.id) == 0) {
+          return absl::DataLossError(
+              absl::StrCat("Unknown item ", event.id, " disappeared"));
+        }
+        break;
+      default:
+        return absl::DataLossError("Unknown event kind");
+    }
+    record.events.push_back(event);
+  }
+  if (!payload.empty()) return absl::DataLossError("Trailing record bytes");
+
+  header_read_ = true;
+  frame_index_ = record.frame_index;
+  positions_ = std::move(positions);
+  *data = input;
+  return record;
+}
+
+}  // namespace aruco
@@ -0,0 +1,85 @@
+// Compact binary stream of projected item positions. Only changes are sent:
+// moves beyond a pixel threshold and visibility transitions, plus periodic
+// full snapshots so consumers can resync.
+//
+// Stream: "ITMD" magic, version byte, then records
+//   type byte ('S' snapshot or 'D' delta), payload size varint, payload
+// Payload: frame index increment varint, entry count varint, entries.
+// Snapshot entry: zigzag id, zigzag x, zigzag y.
+// Delta entry: zigzag id << 2 | kind, then
+//   kMoved: zigzag dx, zigzag dy relative to the last published position,
+//   kAppeared: zigzag x, zigzag y,
+//   kDisappeared: nothing.
+// Coordinates are fixed point in 1/16 px.
+#ifndef ITEM_DELTA_STREAM_H
+#define ITEM_DELTA_STREAM_H
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "opencv2/core.hpp"
+#include "project_points/projection.h"
+
+namespace aruco {
+
+struct ItemEvent {
+  enum class Kind { kMoved = 0, kAppeared = 1, kDisappeared = 2 };
+  Kind kind;
+  int32_t id;
+  // New position, unused for kDisappeared.
+  cv::Point2f point;
+};
+
+struct ItemDeltaRecord {
+  int64_t frame_index = 0;
+  // Snapshot lists every visible item as kAppeared and replaces all state.
+  bool snapshot = false;
+  std::vector<ItemEvent> events;
+};
+
+class ItemDeltaEncoder {
+ public:
+  // Items moving less than pixel_threshold since they were last published
+  // are not sent. Snapshot is sent at least every snapshot_interval frames.
+  ItemDeltaEncoder(float pixel_threshold, int32_t snapshot_interval);
+
+  // Appends records for the frame to output, nothing when nothing changed.
+  // Positions are the items visible in this frame, items that are not listed
+  // are hidden. Ids must be unique within the frame. Frame indices must
+  // increase.
+  void Encode(int64_t frame_index, const std::vector<ItemPosition>& positions,
+              std::string* output);
+
+ private:
+  float pixel_threshold_;
+  int32_t snapshot_interval_;
+  bool header_written_ = false;
+  int64_t last_record_frame_ = 0;
+  int64_t last_snapshot_frame_ = -1;
+  // Last published position in fixed point.
+  std::unordered_map<int32_t, cv::Point> published_;
+};
+
+class ItemDeltaDecoder {
+ public:
+  // Decodes the next record and consumes it from data. Returns OutOfRange
+  // and leaves data untouched if the record is not complete yet, DataLoss on
+  // a corrupted stream.
+  absl::StatusOr<ItemDeltaRecord> Next(absl::string_view* data);
+
+  // Current positions of visible items.
+  const std::unordered_map<int32_t, cv::Point2f>& positions() const {
+    return positions_;
+  }
+
+ private:
+  bool header_read_ = false;
+  int64_t frame_index_ = 0;
+  std::unordered_map<int32_t, cv::Point2f> positions_;
+};
+
+}  // namespace aruco
+
+#endif  // ITEM_DELTA_STREAM_H
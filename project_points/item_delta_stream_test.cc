@@ -0,0 +1,118 @@
+#include "project_points/item_delta_stream.h"
+#include "absl/status/status_matchers.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+
+namespace aruco {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::testing::SizeIs;
+
+std::vector<ItemDeltaRecord> DecodeAll(absl::string_view data,
+                                       ItemDeltaDecoder& decoder) {
+  std::vector<ItemDeltaRecord> records;
+  while (true) {
+    auto record = decoder.Next(&data);
+    if (!record.ok()) {
+      EXPECT_THAT(record, StatusIs(absl::StatusCode::kOutOfRange));
+      break;
+    }
+    records.push_back(*std::move(record));
+  }
+  EXPECT_TRUE(data.empty());
+  return records;
+}
+
+TEST(ItemDeltaStream, StaticSceneOnlySendsSnapshots) {
+  ItemDeltaEncoder encoder(/*pixel_threshold=*/1.0, /*snapshot_interval=*/50);
+  std::string stream;
+  for (int64_t frame = 0; frame < 100; ++frame) {
+    // Jitter below the threshold
+    const float jitter = (frame % 2) * 0.4f;
+    encoder.Encode(frame,
+                   {{.id = 1, .point = cv::Point2f(100 + jitter, 200)},
+                    {.id = 2, .point = cv::Point2f(300, 400 - jitter)}},
+                   &stream);
+  }
+  EXPECT_LT(stream.size(), 40);
+
+  ItemDeltaDecoder decoder;
+  const std::vector<ItemDeltaRecord> records = DecodeAll(stream, decoder);
+  ASSERT_THAT(records, SizeIs(2));
+  EXPECT_TRUE(records[0].snapshot);
+  EXPECT_EQ(records[0].frame_index, 0);
+  EXPECT_THAT(records[0].events, SizeIs(2));
+  EXPECT_TRUE(records[1].snapshot);
+  EXPECT_EQ(records[1].frame_index, 50);
+  EXPECT_THAT(decoder.positions(), SizeIs(2));
+}
+
+TEST(ItemDeltaStream, SendsMovesAndVisibilityChanges) {
+  ItemDeltaEncoder encoder(/*pixel_threshold=*/1.0, /*snapshot_interval=*/1000);
+  std::string stream;
+  encoder.Encode(0, {{.id = 1, .point = cv::Point2f(10, 10)}}, &stream);
+  // Item 1 moves, item 7 appears.
+  encoder.Encode(3,
+                 {{.id = 1, .point = cv::Point2f(12.5, 9.25)},
+                  {.id = 7, .point = cv::Point2f(-5, 600.0625)}},
+                 &stream);
+  // Nothing changes
+  encoder.Encode(4,
+                 {{.id = 1, .point = cv::Point2f(12.5, 9.5)},
+                  {.id = 7, .point = cv::Point2f(-5, 600)}},
+                 &stream);
+  // Item 1 disappears
+  encoder.Encode(9, {{.id = 7, .point = cv::Point2f(-5, 600)}}, &stream);
+
+  ItemDeltaDecoder decoder;
+  const std::vector<ItemDeltaRecord> records = DecodeAll(stream, decoder);
+  ASSERT_THAT(records, SizeIs(3));
+
+  EXPECT_FALSE(records[1].snapshot);
+  EXPECT_EQ(records[1].frame_index, 3);
+  ASSERT_THAT(records[1].events, SizeIs(2));
+  EXPECT_EQ(records[1].events[0].kind, ItemEvent::Kind::kMoved);
+  EXPECT_EQ(records[1].events[0].id, 1);
+  EXPECT_EQ(records[1].events[0].point, cv::Point2f(12.5, 9.25));
+  EXPECT_EQ(records[1].events[1].kind, ItemEvent::Kind::kAppeared);
+  EXPECT_EQ(records[1].events[1].id, 7);
+  EXPECT_EQ(records[1].events[1].point, cv::Point2f(-5, 600.0625));
+
+  EXPECT_EQ(records[2].frame_index, 9);
+  ASSERT_THAT(records[2].events, SizeIs(1));
+  EXPECT_EQ(records[2].events[0].kind, ItemEvent::Kind::kDisappeared);
+  EXPECT_EQ(records[2].events[0].id, 1);
+
+  ASSERT_THAT(decoder.positions(), SizeIs(1));
+  EXPECT_EQ(decoder.positions().at(7), cv::Point2f(-5, 600.0625));
+}
+
+TEST(ItemDeltaStream, IncompleteRecordIsNotConsumed) {
+  ItemDeltaEncoder encoder(/*pixel_threshold=*/1.0, /*snapshot_interval=*/10);
+  std::string stream;
+  encoder.Encode(0, {{.id = 1, .point = cv::Point2f(10, 10)}}, &stream);
+
+  ItemDeltaDecoder decoder;
+  absl::string_view partial(stream.data(), stream.size() - 1);
+  EXPECT_THAT(decoder.Next(&partial), StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_EQ(partial.size(), stream.size() - 1);
+
+  absl::string_view complete(stream);
+  EXPECT_THAT(decoder.Next(&complete), IsOk());
+  EXPECT_TRUE(complete.empty());
+}
+
+TEST(ItemDeltaStream, RejectsCorruptedStream) {
+  ItemDeltaDecoder decoder;
+  absl::string_view garbage("not a stream");
+  EXPECT_THAT(decoder.Next(&garbage), StatusIs(absl::StatusCode::kDataLoss));
+  // Right magic, unknown version.
+  const std::string other_version("ITMD\x7fS", 6);
+  absl::string_view other(other_version);
+  EXPECT_THAT(decoder.Next(&other), StatusIs(absl::StatusCode::kDataLoss));
+}
+
+}  // namespace
+}  // namespace aruco
@@ -0,0 +1,165 @@
+#include "project_points/latency_controller.h"
+#include <algorithm>
+#include <utility>
+#include "absl/strings/str_format.h"
+#include "opencv2/imgproc.hpp"
+#include "project_points/projection.h"
+#include "project_points/trace.h"
+
+namespace aruco {
+
+std::string DescribeEffort(const DetectionEffort& effort) {
+  return absl::StrFormat(
+      "scale %.2f, threshold windows %d-%d, corner refinement %s, keyframe "
+      "every %d frames",
+      effort.scale, effort.adaptive_thresh_win_size_min,
+      effort.adaptive_thresh_win_size_max,
+      effort.refine_corners ? "on" : "off", effort.keyframe_interval);
+}
+
+std::vector<DetectionEffort> DefaultEffortLevels(
+    const cv::aruco::DetectorParameters& base) {
+  const DetectionEffort full = {
+      .scale = 1.0,
+      .adaptive_thresh_win_size_min = base.adaptiveThreshWinSizeMin,
+      .adaptive_thresh_win_size_max = base.adaptiveThreshWinSizeMax,
+      .refine_corners =
+          base.cornerRefinementMethod != cv::aruco::CORNER_REFINE_NONE,
+      .keyframe_interval = 1};
+  const std::vector<DetectionEffort> reduced = {
+      {.scale = 1.0,
+       .adaptive_thresh_win_size_min = 3,
+       .adaptive_thresh_win_size_max = 23,
+       .refine_corners = false,
+       .keyframe_interval = 1},
+      {.scale = 0.75,
+       .adaptive_thresh_win_size_min = 3,
+       .adaptive_thresh_win_size_max = 13,
+       .refine_corners = false,
+       .keyframe_interval = 1},
+      {.scale = 0.5,
+       .adaptive_thresh_win_size_min = 3,
+       .adaptive_thresh_win_size_max = 13,
+       .refine_corners = false,
+       .keyframe_interval = 1},
+      {.scale = 0.5,
+       .adaptive_thresh_win_size_min = 13,
+       .adaptive_thresh_win_size_max = 13,
+       .refine_corners = false,
+       .keyframe_interval = 1},
+      {.scale = 0.5,
+       .adaptive_thresh_win_size_min = 13,
+       .adaptive_thresh_win_size_max = 13,
+       .refine_corners = false,
+       .keyframe_interval = 2},
+      {.scale = 0.5,
+       .adaptive_thresh_win_size_min = 13,
+       .adaptive_thresh_win_size_max = 13,
+       .refine_corners = false,
+       .keyframe_interval = 3},
+  };
+  auto window_range = [](const DetectionEffort& effort) {
+    return effort.adaptive_thresh_win_size_max -
+           effort.adaptive_thresh_win_size_min;
+  };
+  std::vector<DetectionEffort> levels = {full};
+  for (DetectionEffort level : reduced) {
+    if (window_range(level) > window_range(full)) {
+      level.adaptive_thresh_win_size_min = full.adaptive_thresh_win_size_min;
+      level.adaptive_thresh_win_size_max = full.adaptive_thresh_win_size_max;
+    }
+    if (level != levels.back()) levels.push_back(level);
+  }
+  return levels;
+}
+
+void ApplyEffort(const DetectionEffort& effort,
+                 cv::aruco::DetectorParameters& params) {
+  params.adaptiveThreshWinSizeMin = effort.adaptive_thresh_win_size_min;
+  params.adaptiveThreshWinSizeMax = effort.adaptive_thresh_win_size_max;
+  if (!effort.refine_corners) {
+    params.cornerRefinementMethod = cv::aruco::CORNER_REFINE_NONE;
+  } else if (params.cornerRefinementMethod == cv::aruco::CORNER_REFINE_NONE) {
+    params.cornerRefinementMethod = cv::aruco::CORNER_REFINE_SUBPIX;
+  }
+}
+
+DetectedMarkers DetectWithEffort(const cv::Mat& frame,
+                                 const DetectionEffort& effort,
+                                 const cv::aruco::ArucoDetector& detector,
+                                 cv::Mat& scratch) {
+  if (effort.scale >= 1.0) return DetectArucoPoints(frame, detector);
+  {
+    TraceScope scope("downscale");
+    cv::resize(frame, scratch, cv::Size(), effort.scale, effort.scale,
+               cv::INTER_AREA);
+  }
+  const DetectedMarkers scaled = DetectArucoPoints(scratch, detector);
+  // Pixel centers: full resolution x maps to (x + 0.5) * scale - 0.5.
+  const float inverse_scale = static_cast<float>(1.0 / effort.scale);
+  const cv::Point2f offset(0.5f, 0.5f);
+  // Starts from a copy so that the dropped count is kept, every marker is
+  // then replaced by its full resolution version.
+  DetectedMarkers markers = scaled;
+  for (DetectedMarker marker : scaled) {
+    for (cv::Point2f& corner : marker.corners) {
+      corner = (corner + offset) * inverse_scale - offset;
+    }
+    marker.center = (marker.center + offset) * inverse_scale - offset;
+    markers.Insert(marker);
+  }
+  return markers;
+}
+
+LatencyController::LatencyController(std::vector<DetectionEffort> levels,
+                                     const LatencyControllerOptions& options)
+    : levels_(std::move(levels)),
+      options_(options),
+      stats_(levels_.size()),
+      level_start_ticks_(cv::getTickCount()) {
+  CV_Assert(!levels_.empty());
+}
+
+std::optional<LevelChange> LatencyController::Update(double processing_ms) {
+  LevelStats& stats = stats_[level_];
+  ++stats.frames;
+  stats.processing_ms += processing_ms;
+
+  const double frame_ms =
+      processing_ms / std::max(1, effort().keyframe_interval);
+  smoothed_ms_ = smoothed_ms_ < 0 ? frame_ms
+                                  : options_.smoothing * frame_ms +
+                                        (1 - options_.smoothing) * smoothed_ms_;
+  const bool above = smoothed_ms_ > options_.budget_ms * options_.upper_ratio;
+  const bool below = smoothed_ms_ < options_.budget_ms * options_.lower_ratio;
+  frames_above_ = above ? frames_above_ + 1 : 0;
+  frames_below_ = below ? frames_below_ + 1 : 0;
+
+  int32_t next_level = level_;
+  if (frames_above_ >= options_.hold_frames &&
+      level_ + 1 < static_cast<int32_t>(levels_.size())) {
+    next_level = level_ + 1;
+  } else if (frames_below_ >= options_.hold_frames && level_ > 0) {
+    next_level = level_ - 1;
+  }
+  if (next_level == level_) return std::nullopt;
+
+  const int64_t now_ticks = cv::getTickCount();
+  stats.seconds += (now_ticks - level_start_ticks_) / cv::getTickFrequency();
+  level_start_ticks_ = now_ticks;
+  const LevelChange change{
+      .from = level_, .to = next_level, .smoothed_ms = smoothed_ms_};
+  level_ = next_level;
+  frames_above_ = 0;
+  frames_below_ = 0;
+  return change;
+}
+
+std::vector<LevelStats> LatencyController::level_stats() const {
+  std::vector<LevelStats> stats = stats_;
+  stats[level_].seconds +=
+      (cv::getTickCount() - level_start_ticks_) / cv::getTickFrequency();
+  return stats;
+}
+
+}  // namespace aruco
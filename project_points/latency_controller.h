@@ -0,0 +1,114 @@
+// Closed loop control of detection effort to hold a per-frame latency
+// budget. Processing time is smoothed and compared against the budget with
+// hysteresis. Effort drops one level when it stays above the budget and is
+// restored once it stays well below.
+#ifndef LATENCY_CONTROLLER_H
+#define LATENCY_CONTROLLER_H
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "opencv2/core.hpp"
+#include "opencv2/objdetect/aruco_detector.hpp"
+#include "project_points/detected_markers.h"
+
+namespace aruco {
+
+struct DetectionEffort {
+  // Frames are downscaled by this before detection, 1 is full resolution.
+  double scale = 1.0;
+  // DetectorParameters adaptive threshold window range. Fewer windows mean
+  // fewer thresholding passes.
+  int32_t adaptive_thresh_win_size_min = 3;
+  int32_t adaptive_thresh_win_size_max = 23;
+  // Sub-pixel corner refinement.
+  bool refine_corners = false;
+  // Detection runs on every keyframe_interval-th frame, frames in between
+  // reuse the last detection.
+  int32_t keyframe_interval = 1;
+
+  bool operator==(const DetectionEffort&) const = default;
+};
+
+// Human readable summary for logs.
+std::string DescribeEffort(const DetectionEffort& effort);
+
+// Levels from most to least effort. Level 0 is the detector as configured
+// by base, lower levels never use more threshold windows than base.
+std::vector<DetectionEffort> DefaultEffortLevels(
+    const cv::aruco::DetectorParameters& base =
+        cv::aruco::DetectorParameters());
+
+// Sets the effort dependent fields of params. Corner refinement keeps the
+// method of params and falls back to sub-pixel refinement if it has none.
+void ApplyEffort(const DetectionEffort& effort,
+                 cv::aruco::DetectorParameters& params);
+
+// Detects markers on the frame downscaled by effort, in full resolution
+// coordinates. Scratch holds the downscaled frame between calls.
+DetectedMarkers DetectWithEffort(const cv::Mat& frame,
+                                 const DetectionEffort& effort,
+                                 const cv::aruco::ArucoDetector& detector,
+                                 cv::Mat& scratch);
+
+struct LatencyControllerOptions {
+  double budget_ms = 16;
+  // Weight of the latest frame in the smoothed processing time.
+  double smoothing = 0.2;
+  // Effort drops when the smoothed time exceeds budget * upper_ratio and is
+  // raised when it falls below budget * lower_ratio.
+  double upper_ratio = 1.0;
+  double lower_ratio = 0.6;
+  // Frames the condition has to hold before switching. Also the minimum
+  // number of frames between switches.
+  int32_t hold_frames = 15;
+};
+
+struct LevelChange {
+  int32_t from;
+  int32_t to;
+  double smoothed_ms;
+};
+
+struct LevelStats {
+  int64_t frames = 0;
+  double processing_ms = 0;
+  // Wall time the level was active.
+  double seconds = 0;
+};
+
+class LatencyController {
+ public:
+  // Starts at level 0. Levels must not be empty.
+  LatencyController(std::vector<DetectionEffort> levels,
+                    const LatencyControllerOptions& options);
+
+  // Reports processing time of a keyframe. It is spread over the keyframe
+  // interval of the current effort, so the budget holds the mean cost per
+  // frame. Returns the change if the level switched, the new effort applies
+  // to the next frame.
+  std::optional<LevelChange> Update(double processing_ms);
+
+  int32_t level() const { return level_; }
+  const DetectionEffort& effort() const { return levels_[level_]; }
+  const std::vector<DetectionEffort>& levels() const { return levels_; }
+  // Smoothed processing time per frame.
+  double smoothed_ms() const { return smoothed_ms_; }
+
+  // Per level statistics, wall time includes the current level so far.
+  std::vector<LevelStats> level_stats() const;
+
+ private:
+  std::vector<DetectionEffort> levels_;
+  LatencyControllerOptions options_;
+  int32_t level_ = 0;
+  double smoothed_ms_ = -1;
+  int32_t frames_above_ = 0;
+  int32_t frames_below_ = 0;
+  std::vector<LevelStats> stats_;
+  int64_t level_start_ticks_;
+};
+
+}  // namespace aruco
+
+#endif  // LATENCY_CONTROLLER_H
@@ -0,0 +1,167 @@
+#include "project_points/latency_controller.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+#include "opencv2/objdetect/aruco_dictionary.hpp"
+
+namespace aruco {
+namespace {
+
+LatencyControllerOptions Options() {
+  LatencyControllerOptions options;
+  options.budget_ms = 16;
+  options.smoothing = 1.0;  // No smoothing, keeps the frame math simple.
+  options.hold_frames = 5;
+  return options;
+}
+
+// Feeds frames until the level changes, returns the frames it took or -1.
+int32_t FramesUntilChange(LatencyController& controller, double ms,
+                          int32_t max_frames = 100) {
+  for (int32_t i = 1; i <= max_frames; ++i) {
+    if (controller.Update(ms).has_value()) return i;
+  }
+  return -1;
+}
+
+TEST(LatencyController, DropsEffortWhenOverBudget) {
+  LatencyController controller(DefaultEffortLevels(), Options());
+  EXPECT_EQ(controller.level(), 0);
+  EXPECT_EQ(FramesUntilChange(controller, 30), 5);
+  EXPECT_EQ(controller.level(), 1);
+  // Hold restarts after a switch.
+  EXPECT_EQ(FramesUntilChange(controller, 30), 5);
+  EXPECT_EQ(controller.level(), 2);
+}
+
+TEST(LatencyController, StaysAtLastLevel) {
+  const int32_t last = static_cast<int32_t>(DefaultEffortLevels().size()) - 1;
+  LatencyController controller(DefaultEffortLevels(), Options());
+  // Over budget even when spread over three frames.
+  for (int32_t i = 0; i < 1000; ++i) controller.Update(100);
+  EXPECT_EQ(controller.level(), last);
+  EXPECT_EQ(controller.effort().keyframe_interval, 3);
+  EXPECT_NEAR(controller.smoothed_ms(), 100.0 / 3, 1e-9);
+}
+
+TEST(LatencyController, SkipsFramesOnlyAsFarAsNeeded) {
+  LatencyController controller(DefaultEffortLevels(), Options());
+  // 24 ms keyframes: over budget on every frame, 12 ms per frame when every
+  // second frame reuses the detection.
+  for (int32_t i = 0; i < 1000; ++i) controller.Update(24);
+  EXPECT_EQ(controller.effort().keyframe_interval, 2);
+  EXPECT_DOUBLE_EQ(controller.smoothed_ms(), 12);
+  // 8 ms per frame at interval 3 is well below the budget, so effort would
+  // come back to interval 2 right away.
+  const DetectionEffort effort = controller.effort();
+  EXPECT_EQ(FramesUntilChange(controller, 24), -1);
+  EXPECT_EQ(controller.effort(), effort);
+}
+
+TEST(LatencyController, HysteresisBandKeepsLevel) {
+  LatencyController controller(DefaultEffortLevels(), Options());
+  EXPECT_EQ(FramesUntilChange(controller, 30), 5);
+  // Between 0.6 and 1.0 of the budget nothing changes.
+  EXPECT_EQ(FramesUntilChange(controller, 12), -1);
+  // Spikes shorter than the hold don't switch.
+  for (int32_t i = 0; i < 20; ++i) {
+    EXPECT_FALSE(controller.Update(i % 4 == 0 ? 40 : 12).has_value()) << i;
+  }
+  EXPECT_EQ(controller.level(), 1);
+  // Well below the budget effort comes back.
+  const auto change = [&]() {
+    for (int32_t i = 0; i < 10; ++i) {
+      if (auto c = controller.Update(4); c.has_value()) return c;
+    }
+    return std::optional<LevelChange>();
+  }();
+  ASSERT_TRUE(change.has_value());
+  EXPECT_EQ(change->from, 1);
+  EXPECT_EQ(change->to, 0);
+  EXPECT_EQ(FramesUntilChange(controller, 4), -1);
+}
+
+TEST(LatencyController, SmoothsSpikes) {
+  LatencyControllerOptions options = Options();
+  options.smoothing = 0.1;
+  options.hold_frames = 2;
+  LatencyController controller(DefaultEffortLevels(), options);
+  // Two 40 ms frames every 20 frames of 8 ms. Unsmoothed they would outlast
+  // the hold.
+  for (int32_t i = 0; i < 200; ++i) {
+    controller.Update(i % 20 >= 18 ? 40 : 8);
+    EXPECT_EQ(controller.level(), 0) << i;
+  }
+}
+
+TEST(LatencyController, CountsFramesPerLevel) {
+  LatencyController controller(DefaultEffortLevels(), Options());
+  for (int32_t i = 0; i < 5; ++i) controller.Update(30);
+  for (int32_t i = 0; i < 3; ++i) controller.Update(12);
+  const std::vector<LevelStats> stats = controller.level_stats();
+  ASSERT_THAT(stats, testing::SizeIs(DefaultEffortLevels().size()));
+  EXPECT_EQ(stats[0].frames, 5);
+  EXPECT_DOUBLE_EQ(stats[0].processing_ms, 150);
+  EXPECT_EQ(stats[1].frames, 3);
+  EXPECT_DOUBLE_EQ(stats[1].processing_ms, 36);
+  EXPECT_EQ(stats[2].frames, 0);
+  EXPECT_GE(stats[1].seconds, 0);
+}
+
+TEST(DefaultEffortLevels, StartsAtConfiguredDetector) {
+  const std::vector<DetectionEffort> levels = DefaultEffortLevels();
+  ASSERT_THAT(levels, testing::Not(testing::IsEmpty()));
+  // Same cost as the default detector, not more.
+  cv::aruco::DetectorParameters params;
+  ApplyEffort(levels.front(), params);
+  const cv::aruco::DetectorParameters defaults;
+  EXPECT_EQ(levels.front().scale, 1.0);
+  EXPECT_EQ(params.adaptiveThreshWinSizeMin, defaults.adaptiveThreshWinSizeMin);
+  EXPECT_EQ(params.adaptiveThreshWinSizeMax, defaults.adaptiveThreshWinSizeMax);
+  EXPECT_EQ(params.cornerRefinementMethod, defaults.cornerRefinementMethod);
+  for (size_t i = 1; i < levels.size(); ++i) {
+    EXPECT_NE(levels[i], levels[i - 1]) << i;
+  }
+}
+
+TEST(DefaultEffortLevels, NeverWidensTunedWindows) {
+  cv::aruco::DetectorParameters tuned;
+  tuned.adaptiveThreshWinSizeMin = 7;
+  tuned.adaptiveThreshWinSizeMax = 7;
+  tuned.cornerRefinementMethod = cv::aruco::CORNER_REFINE_CONTOUR;
+  const std::vector<DetectionEffort> levels = DefaultEffortLevels(tuned);
+  ASSERT_THAT(levels, testing::Not(testing::IsEmpty()));
+  EXPECT_TRUE(levels.front().refine_corners);
+  for (const DetectionEffort& effort : levels) {
+    SCOPED_TRACE(DescribeEffort(effort));
+    EXPECT_LE(effort.adaptive_thresh_win_size_max -
+                  effort.adaptive_thresh_win_size_min,
+              0);
+  }
+  // The tuned refinement method is kept at level 0.
+  ApplyEffort(levels.front(), tuned);
+  EXPECT_EQ(tuned.cornerRefinementMethod, cv::aruco::CORNER_REFINE_CONTOUR);
+}
+
+TEST(DetectWithEffort, MapsDownscaledDetectionsToFullResolution) {
+  const cv::aruco::Dictionary dictionary =
+      cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
+  cv::Mat frame(720, 1280, CV_8UC1, cv::Scalar(255));
+  cv::Mat marker;
+  cv::aruco::generateImageMarker(dictionary, 3, 200, marker, 1);
+  marker.copyTo(frame(cv::Rect(400, 200, 200, 200)));
+
+  cv::aruco::DetectorParameters params;
+  cv::Mat scratch;
+  for (const DetectionEffort& effort : DefaultEffortLevels()) {
+    SCOPED_TRACE(DescribeEffort(effort));
+    ApplyEffort(effort, params);
+    const cv::aruco::ArucoDetector detector(dictionary, params);
+    const DetectedMarkers markers =
+        DetectWithEffort(frame, effort, detector, scratch);
+    ASSERT_TRUE(markers.contains(3));
+    EXPECT_LE(cv::norm(markers.at(3).center - cv::Point2f(499.5, 299.5)), 1.5);
+  }
+}
+
+}  // namespace
+}  // namespace aruco
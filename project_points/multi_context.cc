@@ -0,0 +1,65 @@
+#include "project_points/multi_context.h"
+#include "absl/strings/str_cat.h"
+#include "project_points/trace.h"
+
+namespace aruco {
+
+std::vector<DetectedMarkers> PartitionMarkers(
+    const std::vector<Context>& contexts, const DetectedMarkers& markers) {
+  std::vector<DetectedMarkers> partition(contexts.size());
+  for (size_t c = 0; c < contexts.size(); ++c) {
+    for (size_t i = 0; i < contexts[c].object_points.size(); ++i) {
+      if (const DetectedMarker* marker =
+              markers.Find(BoundaryMarkerId(contexts[c], i))) {
+        partition[c].Insert(*marker);
+      }
+    }
+  }
+  return partition;
+}
+
+std::vector<ContextResult> ProjectContexts(
+    const IntrinsicCalibration& calibration,
+    const std::vector<Context>& contexts, const DetectedMarkers& markers,
+    bool parallel) {
+  TraceScope scope("project_contexts");
+  std::vector<DetectedMarkers> partition = PartitionMarkers(contexts, markers);
+  std::vector<ContextResult> results(contexts.size());
+  std::vector<int32_t> visible;
+  for (size_t c = 0; c < contexts.size(); ++c) {
+    results[c].markers = partition[c];
+    const size_t boundary_size = contexts[c].object_points.size();
+    if (results[c].markers.size() == boundary_size) {
+      visible.push_back(static_cast<int32_t>(c));
+    } else {
+      results[c].status = absl::FailedPreconditionError(
+          absl::StrCat(results[c].markers.size(), " of ", boundary_size,
+                       " boundary markers detected"));
+    }
+  }
+
+  const auto solve = [&](int32_t c) {
+    auto item_points =
+        ProjectItemPoints(calibration, contexts[c], results[c].markers);
+    if (item_points.ok()) {
+      results[c].item_points = *std::move(item_points);
+    } else {
+      results[c].status = item_points.status();
+    }
+  };
+  // A solve takes tens of microseconds, a single one isn't worth waking the
+  // pool for.
+  if (parallel && visible.size() > 1) {
+    cv::parallel_for_(
+        cv::Range(0, static_cast<int32_t>(visible.size())),
+        [&](const cv::Range& range) {
+          for (int32_t i = range.start; i < range.end; ++i) solve(visible[i]);
+        },
+        /*nstripes=*/static_cast<double>(visible.size()));
+  } else {
+    for (int32_t c : visible) solve(c);
+  }
+  return results;
+}
+
+}  // namespace aruco
@@ -0,0 +1,37 @@
+// Several contexts, e.g. trays, in one frame. Markers are detected once per
+// frame and split by the context owning their id. Contexts with all
+// boundary markers visible are solved in parallel.
+#ifndef MULTI_CONTEXT_H
+#define MULTI_CONTEXT_H
+#include <vector>
+#include "absl/status/status.h"
+#include "opencv2/core.hpp"
+#include "project_points/detected_markers.h"
+#include "project_points/projection.h"
+
+namespace aruco {
+
+struct ContextResult {
+  // FailedPrecondition if boundary markers are missing.
+  absl::Status status;
+  // Detected boundary markers of the context.
+  DetectedMarkers markers;
+  // Projected item points in the context item order. Empty unless ok.
+  std::vector<cv::Point2f> item_points;
+};
+
+// Boundary markers of each context, indexed like contexts. Markers no context
+// owns are dropped.
+std::vector<DetectedMarkers> PartitionMarkers(
+    const std::vector<Context>& contexts, const DetectedMarkers& markers);
+
+// Solves the pose of every context and projects its items. Results are
+// indexed like contexts. Parallel solves visible contexts concurrently.
+std::vector<ContextResult> ProjectContexts(
+    const IntrinsicCalibration& calibration,
+    const std::vector<Context>& contexts, const DetectedMarkers& markers,
+    bool parallel = true);
+
+}  // namespace aruco
+
+#endif  // MULTI_CONTEXT_H
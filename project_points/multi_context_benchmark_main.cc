@@ -0,0 +1,175 @@
+// Measures per frame cost as the number of trays per frame grows. Markers
+// are detected once on a real frame, trays are then solved from synthetic
+// detections of a grid of copies of the manifest context.
+// bazel run -c opt //project_points:multi_context_benchmark_main --
+// --max_trays=16
+#include <cmath>
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "opencv2/calib3d.hpp"
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/objdetect/aruco_dictionary.hpp"
+#include "project_points/multi_context.h"
+#include "project_points/projection.h"
+#include "project_points/proto_utils.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, calibration_path, "testdata/pixel_6a_calibration.txtpb",
+          "Intrinsic camera calibration");
+
+ABSL_FLAG(std::string, manifest_path, "testdata/simple_manifest.txtpb",
+          "Context every tray is a copy of");
+
+ABSL_FLAG(std::string, image_path, "testdata/frame_0.jpg",
+          "Frame to time the single detection pass on");
+
+ABSL_FLAG(std::string, detector_params_path, "",
+          "DetectorParams text proto from tune_detector_main. Empty uses the "
+          "OpenCV defaults.");
+
+ABSL_FLAG(int32_t, max_trays, 16, "Largest number of trays per frame");
+
+ABSL_FLAG(int32_t, iterations, 1000, "Solves per tray count");
+
+// Copies of the template context with their own marker ids, each placed in
+// a grid cell of a plane facing the camera. Returns detections of all of
+// them.
+aruco::DetectedMarkers MakeTrays(const aruco::IntrinsicCalibration& calibration,
+                                 const aruco::Context& tray, int32_t count,
+                                 std::vector<aruco::Context>& contexts) {
+  const int32_t markers_per_tray =
+      static_cast<int32_t>(tray.object_points.size());
+  const int32_t columns =
+      static_cast<int32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+  std::vector<cv::Point3f> object_points;
+  std::vector<cv::Point2f> plane_points;
+  for (const aruco::ObjectPoint& point : tray.object_points) {
+    object_points.push_back(point.point);
+    plane_points.emplace_back(point.point.x, point.point.y);
+  }
+  const cv::Rect bounds = cv::boundingRect(plane_points);
+
+  contexts.clear();
+  aruco::DetectedMarkers markers;
+  for (int32_t t = 0; t < count; ++t) {
+    aruco::Context context = tray;
+    context.name = absl::StrCat("tray_", t);
+    context.marker_ids.clear();
+    for (int32_t i = 0; i < markers_per_tray; ++i) {
+      context.marker_ids.push_back(t * markers_per_tray + i + 1);
+    }
+    // Slightly tilted so every pose solve does real work.
+    const cv::Vec3d rvec(0.05 * (t % 3), -0.05 * (t % 2), 0);
+    const cv::Vec3d tvec((t % columns - columns / 2.0) * bounds.width * 1.2,
+                         (t / columns - columns / 2.0) * bounds.height * 1.2,
+                         bounds.width * 2.0 * columns);
+    std::vector<cv::Point2f> image_points;
+    cv::projectPoints(object_points, rvec, tvec, calibration.camera_matrix,
+                      calibration.distortion_params, image_points);
+    for (int32_t i = 0; i < markers_per_tray; ++i) {
+      aruco::DetectedMarker marker{.id = context.marker_ids[i],
+                                   .center = image_points[i]};
+      marker.corners.fill(image_points[i]);
+      markers.Insert(marker);
+    }
+    contexts.push_back(std::move(context));
+  }
+  return markers;
+}
+
+double MeanSolveMs(const aruco::IntrinsicCalibration& calibration,
+                   const std::vector<aruco::Context>& contexts,
+                   const aruco::DetectedMarkers& markers, bool parallel,
+                   int32_t iterations) {
+  const int64_t start_ticks = cv::getTickCount();
+  for (int32_t i = 0; i < iterations; ++i) {
+    const std::vector<aruco::ContextResult> results =
+        aruco::ProjectContexts(calibration, contexts, markers, parallel);
+    CHECK(results.back().status.ok()) << results.back().status;
+  }
+  return (cv::getTickCount() - start_ticks) / cv::getTickFrequency() *
+         1000.0 / iterations;
+}
+
+absl::Status Run() {
+  ASSIGN_OR_RETURN(
+      auto proto,
+      aruco::LoadFromTextProtoFile<aruco::proto::IntrinsicCalibration>(
+          absl::GetFlag(FLAGS_calibration_path)));
+  const aruco::IntrinsicCalibration calibration =
+      aruco::ConvertIntrinsicCalibrationFromProto(proto);
+  ASSIGN_OR_RETURN(auto manifest,
+                   aruco::LoadFromTextProtoFile<aruco::proto::Context>(
+                       absl::GetFlag(FLAGS_manifest_path)));
+  const aruco::Context tray = aruco::ConvertContextFromProto(manifest);
+
+  const int32_t max_trays = absl::GetFlag(FLAGS_max_trays);
+  const int32_t markers_per_tray =
+      static_cast<int32_t>(tray.object_points.size());
+  if (markers_per_tray == 0 ||
+      max_trays * markers_per_tray > aruco::DetectedMarkers::kCapacity) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "%d trays of %d markers don't fit %d detections", max_trays,
+        markers_per_tray, aruco::DetectedMarkers::kCapacity));
+  }
+
+  const cv::Mat image = cv::imread(absl::GetFlag(FLAGS_image_path));
+  if (image.empty()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Failed to load image '%s'", absl::GetFlag(FLAGS_image_path)));
+  }
+  ASSIGN_OR_RETURN(const cv::aruco::DetectorParameters detector_params,
+                   aruco::LoadDetectorParameters(
+                       absl::GetFlag(FLAGS_detector_params_path)));
+  const cv::aruco::ArucoDetector detector(
+      cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250),
+      detector_params);
+  constexpr int32_t kDetections = 20;
+  const int64_t start_ticks = cv::getTickCount();
+  for (int32_t i = 0; i < kDetections; ++i) {
+    aruco::DetectArucoPoints(image, detector);
+  }
+  const double detect_ms = (cv::getTickCount() - start_ticks) /
+                           cv::getTickFrequency() * 1000.0 / kDetections;
+  LOG(INFO) << absl::StreamFormat("Detection %.2f ms per %dx%d frame on %d "
+                                  "threads",
+                                  detect_ms, image.cols, image.rows,
+                                  cv::getNumThreads());
+
+  const int32_t iterations = absl::GetFlag(FLAGS_iterations);
+  LOG(INFO) << "trays  sequential ms  parallel ms  speedup  frame FPS";
+  std::vector<aruco::Context> contexts;
+  for (int32_t count = 1; count <= max_trays; ++count) {
+    const aruco::DetectedMarkers markers =
+        MakeTrays(calibration, tray, count, contexts);
+    const double sequential_ms =
+        MeanSolveMs(calibration, contexts, markers, /*parallel=*/false,
+                    iterations);
+    const double parallel_ms =
+        MeanSolveMs(calibration, contexts, markers, /*parallel=*/true,
+                    iterations);
+    LOG(INFO) << absl::StreamFormat(
+        "%5d  %13.3f  %11.3f  %7.2f  %9.1f", count, sequential_ms,
+        parallel_ms, sequential_ms / parallel_ms,
+        1000.0 / (detect_ms + parallel_ms));
+  }
+  return absl::OkStatus();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  gflags::SetCommandLineOption("logtostderr", "1");
+  if (const auto status = Run(); !status.ok()) {
+    LOG(ERROR) << "Failed: " << status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
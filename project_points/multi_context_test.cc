@@ -0,0 +1,134 @@
+#include "project_points/multi_context.h"
+#include "absl/status/status_matchers.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+#include "opencv2/calib3d.hpp"
+
+namespace aruco {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+
+IntrinsicCalibration Calibration() {
+  return {.camera_matrix =
+              cv::Mat(cv::Matx33d(1000, 0, 960, 0, 1000, 540, 0, 0, 1)),
+          .distortion_params = cv::Mat::zeros(1, 5, CV_64F)};
+}
+
+Context Tray(std::vector<int32_t> marker_ids, int32_t item_id) {
+  Context context;
+  context.object_points = {{cv::Point3f(0, 0, 0), "tl"},
+                           {cv::Point3f(320, 0, 0), "tr"},
+                           {cv::Point3f(320, 250, 0), "br"},
+                           {cv::Point3f(0, 250, 0), "bl"}};
+  context.item_points = {{item_id, cv::Point3f(110, 100, 0)},
+                         {item_id + 1, cv::Point3f(250, 200, 0)}};
+  context.marker_ids = std::move(marker_ids);
+  return context;
+}
+
+// Image points of the context object points and items seen at tvec.
+struct View {
+  std::vector<cv::Point2f> boundary;
+  std::vector<cv::Point2f> items;
+};
+
+View Project(const Context& context, const cv::Vec3d& rvec,
+             const cv::Vec3d& tvec) {
+  const IntrinsicCalibration calibration = Calibration();
+  std::vector<cv::Point3f> boundary;
+  for (const ObjectPoint& point : context.object_points) {
+    boundary.push_back(point.point);
+  }
+  std::vector<cv::Point3f> items;
+  for (const ItemObjectPoint& point : context.item_points) {
+    items.push_back(point.object_point);
+  }
+  View view;
+  cv::projectPoints(boundary, rvec, tvec, calibration.camera_matrix,
+                    calibration.distortion_params, view.boundary);
+  cv::projectPoints(items, rvec, tvec, calibration.camera_matrix,
+                    calibration.distortion_params, view.items);
+  return view;
+}
+
+void AddMarker(int32_t id, const cv::Point2f& center,
+               DetectedMarkers& markers) {
+  DetectedMarker marker{.id = id, .center = center};
+  marker.corners.fill(center);
+  markers.Insert(marker);
+}
+
+class MultiContextTest : public testing::Test {
+ protected:
+  MultiContextTest()
+      : contexts_({Tray({}, 1), Tray({5, 6, 7, 8}, 10)}),
+        views_({Project(contexts_[0], cv::Vec3d(0.1, -0.2, 0),
+                        cv::Vec3d(-500, -300, 1500)),
+                Project(contexts_[1], cv::Vec3d(-0.2, 0.1, 0.3),
+                        cv::Vec3d(150, 0, 1400))}) {
+    for (size_t c = 0; c < contexts_.size(); ++c) {
+      for (size_t i = 0; i < views_[c].boundary.size(); ++i) {
+        AddMarker(BoundaryMarkerId(contexts_[c], i), views_[c].boundary[i],
+                  markers_);
+      }
+    }
+    // Not part of any context.
+    AddMarker(42, cv::Point2f(100, 100), markers_);
+  }
+
+  const std::vector<Context> contexts_;
+  const std::vector<View> views_;
+  DetectedMarkers markers_;
+};
+
+TEST_F(MultiContextTest, PartitionsByMarkerIds) {
+  const std::vector<DetectedMarkers> partition =
+      PartitionMarkers(contexts_, markers_);
+  ASSERT_THAT(partition, testing::SizeIs(2));
+  ASSERT_THAT(partition[0], testing::SizeIs(4));
+  ASSERT_THAT(partition[1], testing::SizeIs(4));
+  EXPECT_TRUE(partition[0].contains(1));
+  EXPECT_TRUE(partition[0].contains(4));
+  EXPECT_TRUE(partition[1].contains(5));
+  EXPECT_TRUE(partition[1].contains(8));
+  EXPECT_FALSE(partition[1].contains(42));
+}
+
+TEST_F(MultiContextTest, ProjectsEveryContext) {
+  for (const bool parallel : {false, true}) {
+    SCOPED_TRACE(parallel);
+    const std::vector<ContextResult> results =
+        ProjectContexts(Calibration(), contexts_, markers_, parallel);
+    ASSERT_THAT(results, testing::SizeIs(2));
+    for (size_t c = 0; c < results.size(); ++c) {
+      ASSERT_THAT(results[c].status, IsOk()) << c;
+      ASSERT_THAT(results[c].item_points, testing::SizeIs(2));
+      for (size_t i = 0; i < 2; ++i) {
+        EXPECT_LT(cv::norm(results[c].item_points[i] - views_[c].items[i]),
+                  0.1)
+            << c << " " << i;
+      }
+    }
+  }
+}
+
+TEST_F(MultiContextTest, ReportsPartiallyVisibleContexts) {
+  DetectedMarkers markers;
+  for (const DetectedMarker& marker : markers_) {
+    if (marker.id != 6) markers.Insert(marker);
+  }
+  const std::vector<ContextResult> results =
+      ProjectContexts(Calibration(), contexts_, markers);
+  ASSERT_THAT(results, testing::SizeIs(2));
+  EXPECT_THAT(results[0].status, IsOk());
+  EXPECT_THAT(results[0].item_points, testing::SizeIs(2));
+  EXPECT_THAT(results[1].status,
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(results[1].markers, testing::SizeIs(3));
+  EXPECT_THAT(results[1].item_points, testing::IsEmpty());
+}
+
+}  // namespace
+}  // namespace aruco
@@ -1,9 +1,18 @@
 #include "projection.h"
+#include <algorithm>
+#include <cmath>
+#include "absl/strings/str_cat.h"
 #include "opencv2/calib3d.hpp"
 #include "opencv2/objdetect/aruco_detector.hpp"
+#include "project_points/trace.h"
 
 namespace aruco {
 
+int32_t BoundaryMarkerId(const Context& context, size_t index) {
+  return context.marker_ids.empty() ? static_cast<int32_t>(index + 1)
+                                    : context.marker_ids[index];
+}
+
 absl::StatusOr<std::vector<cv::Point2f>> ProjectPoints(
     const IntrinsicCalibration& calibration,
     const std::vector<cv::Point3f>& source_object_points,
@@ -25,14 +34,78 @@ absl::StatusOr<std::vector<cv::Point2f>> ProjectPoints(
   return image_points;
 }
 
-std::unordered_map<int32_t, cv::Point> DetectArucoPoints(
-    const cv::Mat& image, const cv::aruco::Dictionary& dictionary) {
-  std::unordered_map<int32_t, cv::Point> detected_object_points;
+namespace {
+
+struct Correspondences {
+  std::vector<cv::Point3f> object_points;
+  std::vector<cv::Point2f> image_points;
+};
+
+// Pairs context object point i with the center of its boundary marker.
+absl::StatusOr<Correspondences> BoundaryCorrespondences(
+    const Context& context, const DetectedMarkers& detected_points) {
+  Correspondences correspondences;
+  for (size_t i = 0; i < context.object_points.size(); ++i) {
+    const int32_t id = BoundaryMarkerId(context, i);
+    const DetectedMarker* marker = detected_points.Find(id);
+    if (marker == nullptr) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("Boundary point ", id, " is not detected"));
+    }
+    correspondences.object_points.emplace_back(context.object_points[i].point);
+    correspondences.image_points.emplace_back(marker->center);
+  }
+  return correspondences;
+}
+
+}  // namespace
+
+absl::StatusOr<std::vector<cv::Point2f>> ProjectItemPoints(
+    const IntrinsicCalibration& calibration, const Context& context,
+    const DetectedMarkers& detected_points) {
+  TraceScope scope("project_items");
+  auto boundary = BoundaryCorrespondences(context, detected_points);
+  if (!boundary.ok()) return boundary.status();
+  if (context.item_points.empty()) return std::vector<cv::Point2f>();
+
+  std::vector<cv::Point3f> target_object_points;
+  for (const auto& item_point : context.item_points) {
+    target_object_points.emplace_back(item_point.object_point);
+  }
+  return ProjectPoints(calibration, boundary->object_points,
+                       boundary->image_points, target_object_points);
+}
+
+absl::StatusOr<double> BoundaryReprojectionError(
+    const IntrinsicCalibration& calibration, const Context& context,
+    const DetectedMarkers& detected_points) {
+  auto boundary = BoundaryCorrespondences(context, detected_points);
+  if (!boundary.ok()) return boundary.status();
+  auto reprojected =
+      ProjectPoints(calibration, boundary->object_points,
+                    boundary->image_points, boundary->object_points);
+  if (!reprojected.ok()) return reprojected.status();
+  if (reprojected->empty()) return 0.0;
+  double squared_error = 0;
+  for (size_t i = 0; i < reprojected->size(); ++i) {
+    const cv::Point2f delta = reprojected->at(i) - boundary->image_points[i];
+    squared_error += delta.dot(delta);
+  }
+  return std::sqrt(squared_error / reprojected->size());
+}
 
-  std::vector<std::vector<cv::Point2f>> markerCorners, rejectedCandidates;
+DetectedMarkers DetectArucoPoints(const cv::Mat& image,
+                                  const cv::aruco::Dictionary& dictionary) {
   cv::aruco::DetectorParameters detectorParams =
       cv::aruco::DetectorParameters();
   cv::aruco::ArucoDetector detector(dictionary, detectorParams);
+  return DetectArucoPoints(image, detector);
+}
+
+DetectedMarkers DetectArucoPoints(const cv::Mat& image,
+                                  const cv::aruco::ArucoDetector& detector) {
+  TraceScope scope("detect_markers");
+  DetectedMarkers detected_markers;
 
   std::vector<int32_t> ids;
   std::vector<std::vector<cv::Point2f>> corners;
@@ -40,16 +113,17 @@ std::unordered_map<int32_t, cv::Point> DetectArucoPoints(
 
   detector.detectMarkers(image, corners, ids, rejected);
   for (int32_t i = 0; i < static_cast<int32_t>(corners.size()); ++i) {
-    int32_t marker_id = ids[i];
-    cv::Rect bbox = cv::boundingRect(corners[i]);
-    cv::Point center = (bbox.tl() + bbox.br()) / 2;
-    detected_object_points[marker_id] = cv::Point(center.x, center.y);
+    DetectedMarker marker;
+    marker.id = ids[i];
+    std::copy_n(corners[i].begin(), 4, marker.corners.begin());
+    marker.center = MarkerCenter(marker.corners);
+    detected_markers.Insert(marker);
   }
-  return detected_object_points;
+  return detected_markers;
 }
 
-std::unordered_map<int32_t, cv::Point> DetectCorners(const cv::Mat& image) {
-  std::unordered_map<int32_t, cv::Point> detected_object_points;
+DetectedMarkers DetectCorners(const cv::Mat& image) {
+  DetectedMarkers detected_object_points;
 
   // Preprocessing
   int64 start = cv::getTickCount();
@@ -94,7 +168,11 @@ std::unordered_map<int32_t, cv::Point> DetectCorners(const cv::Mat& image) {
   // Take first 4 points
   for (int32_t i = 0; i < std::min(static_cast<int32_t>(corners.size()), 4);
        ++i) {
-    detected_object_points[i + 1] = cv::Point(corners[i].x, corners[i].y);
+    DetectedMarker corner;
+    corner.id = i + 1;
+    corner.corners.fill(corners[i]);
+    corner.center = corners[i];
+    detected_object_points.Insert(corner);
   }
 
   return detected_object_points;
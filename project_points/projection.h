@@ -4,8 +4,9 @@
 #include "opencv2/calib3d.hpp"
 #include "opencv2/imgproc.hpp"
 // #include "calibration_data.pb.h"
-#include <unordered_map>
+#include "opencv2/objdetect/aruco_detector.hpp"
 #include "opencv2/objdetect/aruco_dictionary.hpp"
+#include "project_points/detected_markers.h"
 
 namespace aruco {
 
@@ -30,20 +31,52 @@ struct ItemObjectPoint {
   cv::Point3f object_point;
 };
 
+// Projected item point in image coordinates. Id is ItemObjectPoint id.
+struct ItemPosition {
+  int32_t id;
+  cv::Point2f point;
+};
+
 struct Context {
   std::vector<ObjectPoint> object_points;
   std::vector<Item> items;
   std::vector<ItemObjectPoint> item_points;
+  // Boundary marker id per object point. Empty means ids 1..N in object
+  // point order.
+  std::vector<int32_t> marker_ids;
+  std::string name;
 };
 
+// Id of the boundary marker at object point index.
+int32_t BoundaryMarkerId(const Context& context, size_t index);
+
+
+// Detects Aruco markers for the given dictionary with default detector
+// parameters. Corners are contour vertices, centers are perspective correct.
+// Markers beyond DetectedMarkers::kCapacity are counted as dropped.
+DetectedMarkers DetectArucoPoints(const cv::Mat& image,
+                                  const cv::aruco::Dictionary& dictionary);
+
+// Same with a detector built by the caller, which avoids rebuilding it per
+// image.
+DetectedMarkers DetectArucoPoints(const cv::Mat& image,
+                                  const cv::aruco::ArucoDetector& detector);
+
+// Detects corners of the biggest contour as ids 1..4.
+DetectedMarkers DetectCorners(const cv::Mat& image);
 
-// Detects Aruco corners in the map for the given dictionary.
-// It can return 0..4 detected points
-std::unordered_map<int32_t, cv::Point>DetectArucoPoints(const cv::Mat& image,
-  const cv::aruco::Dictionary& dictionary);
+// Projects context item points given detected boundary points. Context
+// object point i corresponds to the marker BoundaryMarkerId(context, i), all
+// of them must be detected. Other detected markers are ignored.
+absl::StatusOr<std::vector<cv::Point2f>> ProjectItemPoints(
+    const IntrinsicCalibration& calibration, const Context& context,
+    const DetectedMarkers& detected_points);
 
-// Detects corners of the biggest contour.
-std::unordered_map<int32_t, cv::Point>DetectCorners(const cv::Mat& image);
+// Root mean square distance in pixels between detected marker centers and
+// context object points reprojected with the pose recovered from them.
+absl::StatusOr<double> BoundaryReprojectionError(
+    const IntrinsicCalibration& calibration, const Context& context,
+    const DetectedMarkers& detected_points);
 
 // Projects source object points to the taget and returns image points.
 absl::StatusOr<std::vector<cv::Point2f>> ProjectPoints(const IntrinsicCalibration& calibration,
@@ -4,19 +4,28 @@
 // --manifest_path=testdata/local/real_tray/real_manifest.txtpb
 #include <oneapi/tbb/detail/_task.h>
 #include <filesystem>
+#include <fstream>
+#include <optional>
 #include <unordered_set>
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "opencv2/core.hpp"
 #include "opencv2/highgui.hpp"
+#include "opencv2/objdetect/aruco_detector.hpp"
 #include "opencv2/objdetect/aruco_dictionary.hpp"
+#include "project_points/frame_recording.h"
 #include "project_points/highgui_utils.h"
+#include "project_points/item_delta_stream.h"
+#include "project_points/multi_context.h"
 #include "project_points/projection.h"
 #include "project_points/proto_utils.h"
+#include "project_points/trace.h"
+#include "project_points/undistortion.h"
 #include "status_macros.h"
 
 ABSL_FLAG(std::string, image_or_video_path, "testdata/scan.mp4",
@@ -26,76 +35,188 @@ ABSL_FLAG(std::string, calibration_path, "testdata/pixel_6a_calibration.txtpb",
           "Intrinsic camera calibration");
 
 ABSL_FLAG(std::string, manifest_path, "testdata/simple_manifest.txtpb",
-          "Manifest text proto file");
+          "Manifest text proto file, a Context or a Station of several");
 
 ABSL_FLAG(std::string, output_video_path, "", "Output of projection");
 
-// Projects points for the given image. Mutates image.
-absl::Status ProcessImage(const cv::Mat& image,
-                          const aruco::IntrinsicCalibration& calibration,
-                          const aruco::Context& context) {
-  const cv::aruco::Dictionary kDictionary =
-      cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
-  const std::unordered_map<int32_t, cv::Point> detected_points =
-      aruco::DetectArucoPoints(image, kDictionary);
+ABSL_FLAG(std::string, detector_params_path, "",
+          "DetectorParams text proto from tune_detector_main. Empty uses the "
+          "OpenCV defaults.");
+
+ABSL_FLAG(bool, replay_as_fast_as_possible, false,
+          "Replays .frames recordings without the original capture cadence");
+
+ABSL_FLAG(double, preview_fps, 15,
+          "Maximum preview rate, independent of the processing rate. 0 shows "
+          "every frame.");
+
+ABSL_FLAG(std::string, item_stream_path, "",
+          "Writes binary item delta stream of projected item positions");
+
+ABSL_FLAG(double, item_stream_threshold_px, 1.0,
+          "Item moves below this many pixels are not streamed");
+
+ABSL_FLAG(int32_t, item_stream_snapshot_interval, 300,
+          "Frames between full snapshots in the item stream");
+
+ABSL_FLAG(bool, rectify, false,
+          "Shows and writes undistorted images and video frames with the "
+          "overlay mapped into them. Detection and the item stream stay in "
+          "frame pixels.");
+
+ABSL_FLAG(int32_t, rectify_roi_margin_px, -1,
+          "With --rectify only undistorts this margin around the overlay, "
+          "the rest of the frame is black. Frames without overlay and -1 "
+          "undistort the whole frame.");
+
+ABSL_FLAG(std::string, trace_path, "",
+          "Writes a Chrome trace event timeline of every frame stage, for "
+          "chrome://tracing or ui.perfetto.dev");
+
+// Context name for logs, the manifest index if unnamed.
+std::string ContextLabel(const aruco::Context& context, size_t index) {
+  return context.name.empty() ? absl::StrCat("Context ", index) : context.name;
+}
+
+struct FrameResult {
+  aruco::Overlay overlay;
+  // Projected items that are inside the image.
+  std::vector<aruco::ItemPosition> items;
+  // Per context in manifest order.
+  std::vector<aruco::ContextResult> contexts;
+};
+
+// Projects points for the given image. Markers are detected once and every
+// context is solved from its own boundary markers. Returns what to draw, the
+// image is not modified.
+absl::StatusOr<FrameResult> ProcessImage(
+    const cv::Mat& image, const aruco::IntrinsicCalibration& calibration,
+    const std::vector<aruco::Context>& contexts,
+    const cv::aruco::ArucoDetector& detector) {
+  const aruco::DetectedMarkers detected_points =
+      aruco::DetectArucoPoints(image, detector);
+  if (detected_points.dropped() > 0) {
+    LOG(WARNING) << "Dropped " << detected_points.dropped()
+                 << " markers beyond " << aruco::DetectedMarkers::kCapacity;
+  }
   const std::vector<cv::Scalar> corner_colors = {
       aruco::kMAGENTA, aruco::kCYAN, aruco::kYELLOW, aruco::kORANGE};
-  for (int i = 1; i <= 4; ++i) {
-    if (detected_points.contains(i)) {
-      aruco::DrawCircle(image, detected_points.at(i), corner_colors[i - 1]);
+  FrameResult result;
+  result.contexts =
+      aruco::ProjectContexts(calibration, contexts, detected_points);
+  aruco::Overlay& overlay = result.overlay;
+  const cv::Rect2f bounds(0, 0, image.cols, image.rows);
+  for (size_t c = 0; c < contexts.size(); ++c) {
+    const aruco::Context& context = contexts[c];
+    const aruco::ContextResult& context_result = result.contexts[c];
+    for (size_t i = 0; i < context.object_points.size(); ++i) {
+      if (const aruco::DetectedMarker* marker = context_result.markers.Find(
+              aruco::BoundaryMarkerId(context, i))) {
+        overlay.points.push_back({.point = marker->center,
+                                  .color = corner_colors[i % 4]});
+      }
+    }
+    if (!context_result.status.ok()) {
+      // Missing boundary markers are expected while trays move in and out.
+      if (!absl::IsFailedPrecondition(context_result.status)) {
+        LOG(WARNING) << "Failed to ProjectPoints for "
+                     << ContextLabel(context, c) << ": "
+                     << context_result.status.message();
+      }
+      continue;
+    }
+    for (size_t i = 0; i < context_result.item_points.size(); ++i) {
+      const cv::Point2f& point = context_result.item_points[i];
+      overlay.points.push_back(
+          {.point = point, .color = aruco::kGREEN, .size = 50});
+      if (bounds.contains(point)) {
+        result.items.push_back(
+            {.id = context.item_points[i].id, .point = point});
+      }
     }
   }
-  if (detected_points.size() != 4) return absl::OkStatus();
 
-  // Getting from context
-  std::vector<cv::Point3f> source_object_points;
-  for (const auto& object_point : context.object_points) {
-    source_object_points.emplace_back(object_point.point);
-  }
+  return result;
+}
 
-  // TODO: Ignore ID so far
-  std::vector<cv::Point3f> target_source_points;
-  for (const auto& item_point : context.item_points) {
-    target_source_points.emplace_back(item_point.object_point);
-  }
-  std::vector<cv::Point2f> source_image_points;
-  for (int i = 1; i <= 4; ++i) {
-    source_image_points.emplace_back(detected_points.at(i));
+// Maps overlay points and markers into the rectified frame.
+void RectifyOverlay(const aruco::Undistortion& undistortion,
+                    aruco::Overlay& overlay) {
+  std::vector<cv::Point2f> points;
+  for (const aruco::OverlayPoint& point : overlay.points) {
+    points.push_back(point.point);
   }
-  auto result = aruco::ProjectPoints(calibration, source_object_points,
-                                     source_image_points, target_source_points);
-  if (!result.ok()) {
-    LOG(WARNING) << "Failed to ProjectPoints";
+  for (const aruco::DetectedMarker& marker : overlay.markers) {
+    points.insert(points.end(), marker.corners.begin(), marker.corners.end());
+    points.push_back(marker.center);
   }
-  for (const cv::Point2f& point : result.value()) {
-    aruco::DrawCircle(image, point, aruco::kGREEN, /*size=*/50);
+  const std::vector<cv::Point2f> rectified =
+      undistortion.RectifyPoints(points);
+  auto next = rectified.begin();
+  for (aruco::OverlayPoint& point : overlay.points) point.point = *next++;
+  aruco::DetectedMarkers markers;
+  for (aruco::DetectedMarker marker : overlay.markers) {
+    for (cv::Point2f& corner : marker.corners) corner = *next++;
+    marker.center = *next++;
+    markers.Insert(marker);
   }
+  overlay.markers = markers;
+}
 
-  return absl::OkStatus();
+// Undistorts frame into rectified and maps overlay into it. With a non
+// negative roi_margin only that margin around the overlay points is remapped.
+void RectifyFrame(const aruco::Undistortion& undistortion,
+                  const cv::Mat& frame, int32_t roi_margin,
+                  aruco::Overlay& overlay, cv::Mat& rectified) {
+  RectifyOverlay(undistortion, overlay);
+  cv::Rect roi;
+  if (roi_margin >= 0) {
+    std::vector<cv::Point2f> points;
+    for (const aruco::OverlayPoint& point : overlay.points) {
+      points.push_back(point.point);
+    }
+    roi = undistortion.RoiAround(points, roi_margin);
+  }
+  undistortion.Remap(frame, rectified, roi);
 }
 
 // Process image and outputs to cv::imShow
 absl::Status RunImage(const aruco::IntrinsicCalibration& calibration,
-                      const aruco::Context& context) {
+                      const std::vector<aruco::Context>& contexts,
+                      const cv::aruco::ArucoDetector& detector) {
   const cv::Mat image = cv::imread(absl::GetFlag(FLAGS_image_or_video_path));
   if (image.empty()) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Failed to open image '%s'", absl::GetFlag(FLAGS_image_or_video_path)));
   }
-  RETURN_IF_ERROR(ProcessImage(image, calibration, context));
+  ASSIGN_OR_RETURN(FrameResult result,
+                   ProcessImage(image, calibration, contexts, detector));
+  for (size_t c = 0; c < contexts.size(); ++c) {
+    LOG(INFO) << ContextLabel(contexts[c], c) << ": "
+              << result.contexts[c].status;
+  }
+
+  cv::Mat output = image;
+  if (absl::GetFlag(FLAGS_rectify)) {
+    ASSIGN_OR_RETURN(const aruco::Undistortion undistortion,
+                     aruco::Undistortion::Create(calibration, image.size()));
+    RectifyFrame(undistortion, image,
+                 absl::GetFlag(FLAGS_rectify_roi_margin_px), result.overlay,
+                 output);
+  }
 
-  constexpr absl::string_view kWindow = "Detection";
-  cv::namedWindow(kWindow.data(), cv::WINDOW_FREERATIO);
-  cv::imshow(kWindow.data(), image);
-  cv::waitKey(0);
+  aruco::PreviewWindow preview("Detection", /*max_fps=*/0);
+  preview.Show(output, result.overlay, /*wait_for_key=*/true);
 
   return absl::OkStatus();
 }
 
-// Runs video. Shows in cv::imShow and can write output video.
-absl::Status RunVideo(const aruco::IntrinsicCalibration& calibration,
-                      const aruco::Context& context) {
-  cv::VideoCapture cap(absl::GetFlag(FLAGS_image_or_video_path));
+// Runs video or replayed recording. Shows downscaled preview and can write
+// full resolution output video.
+absl::Status RunVideo(cv::VideoCapture& cap,
+                      const aruco::IntrinsicCalibration& calibration,
+                      const std::vector<aruco::Context>& contexts,
+                      const cv::aruco::ArucoDetector& detector) {
   if (!cap.isOpened()) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Failed to open video '%s'", absl::GetFlag(FLAGS_image_or_video_path)));
@@ -120,29 +241,91 @@ absl::Status RunVideo(const aruco::IntrinsicCalibration& calibration,
       LOG(ERROR) << "Failed to open output video";
     }
   }
+  std::ofstream item_stream;
+  if (!absl::GetFlag(FLAGS_item_stream_path).empty()) {
+    item_stream.open(absl::GetFlag(FLAGS_item_stream_path), std::ios::binary);
+    if (!item_stream) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Failed to open item stream '%s'",
+                          absl::GetFlag(FLAGS_item_stream_path)));
+    }
+  }
+  aruco::ItemDeltaEncoder item_encoder(
+      absl::GetFlag(FLAGS_item_stream_threshold_px),
+      absl::GetFlag(FLAGS_item_stream_snapshot_interval));
+  std::string item_records;
+
+  // Built on the first frame, the capture may not report its size.
+  std::optional<aruco::Undistortion> undistortion;
+  const int32_t roi_margin = absl::GetFlag(FLAGS_rectify_roi_margin_px);
+  cv::Mat rectified;
+
   cv::Mat frame;
-  constexpr absl::string_view kWindow = "Projection";
-  cv::namedWindow(kWindow.data(), cv::WINDOW_FREERATIO);
+  aruco::PreviewWindow preview("Projection", absl::GetFlag(FLAGS_preview_fps));
 
   int32_t frame_count = 0;
   int64_t total_processing_ticks = 0;
-  while (cap.read(frame)) {
+  std::vector<int32_t> solved_frames(contexts.size(), 0);
+  auto read_frame = [&cap, &frame, &frame_count]() {
+    aruco::TraceScope scope("read", frame_count);
+    return cap.read(frame);
+  };
+  while (read_frame()) {
+    aruco::TraceScope frame_scope("frame", frame_count);
     ++frame_count;
     int64_t start_ticks = cv::getTickCount();
-    auto status = ProcessImage(frame, calibration, context);
+    auto result = [&]() {
+      aruco::TraceScope scope("process");
+      return ProcessImage(frame, calibration, contexts, detector);
+    }();
     const int64_t end_ticks = cv::getTickCount();
 
-    if (!status.ok()) {
+    if (!result.ok()) {
       LOG(ERROR) << "Failed to process frame";
       continue;
     }
     total_processing_ticks += (end_ticks - start_ticks);
+    for (size_t c = 0; c < contexts.size(); ++c) {
+      if (result->contexts[c].status.ok()) ++solved_frames[c];
+    }
 
-    if (writer.isOpened()) writer.write(frame);
-    cv::imshow(kWindow.data(), frame);
+    if (item_stream.is_open()) {
+      aruco::TraceScope scope("item_stream");
+      item_records.clear();
+      item_encoder.Encode(frame_count - 1, result->items, &item_records);
+      item_stream.write(item_records.data(), item_records.size());
+    }
+
+    // Checked once, so that a frame rectified for the preview is also shown.
+    const bool show_preview = preview.Due();
+    cv::Mat output = frame;
+    if (absl::GetFlag(FLAGS_rectify) && (writer.isOpened() || show_preview)) {
+      if (!undistortion.has_value()) {
+        ASSIGN_OR_RETURN(
+            undistortion,
+            aruco::Undistortion::Create(calibration, frame.size()));
+      }
+      RectifyFrame(*undistortion, frame, roi_margin, result->overlay,
+                   rectified);
+      output = rectified;
+    }
 
-    if (const int key = cv::waitKey(33) & 0xFF; key == 27)
-      break;  // ESC key only
+    // Full resolution frame is only drawn on when it is written out.
+    if (writer.isOpened()) {
+      {
+        aruco::TraceScope scope("draw");
+        aruco::DrawOverlay(output, result->overlay);
+      }
+      aruco::TraceScope scope("encode");
+      writer.write(output);
+    }
+    if (show_preview) {
+      const aruco::Overlay& preview_overlay =
+          writer.isOpened() ? aruco::Overlay() : result->overlay;
+      if (const int key = preview.Show(output, preview_overlay) & 0xFF;
+          key == 27)
+        break;  // ESC key only
+    }
   }
   const double total_processing_time_ms =
       total_processing_ticks / cv::getTickFrequency() * 1000.0;
@@ -151,6 +334,11 @@ absl::Status RunVideo(const aruco::IntrinsicCalibration& calibration,
   const double mean_ms_per_frame = total_processing_time_ms / frame_count;
   LOG(INFO) << absl::StreamFormat("Mean FPS: %.0f", processing_fps);
   LOG(INFO) << absl::StreamFormat("Mean latency %.0f ms", mean_ms_per_frame);
+  for (size_t c = 0; c < contexts.size(); ++c) {
+    LOG(INFO) << absl::StreamFormat("%s: solved in %d of %d frames",
+                                    ContextLabel(contexts[c], c),
+                                    solved_frames[c], frame_count);
+  }
 
   return absl::OkStatus();
 }
@@ -167,19 +355,32 @@ absl::Status Run() {
   aruco::IntrinsicCalibration calibration =
       aruco::ConvertIntrinsicCalibrationFromProto(proto);
 
-  ASSIGN_OR_RETURN(auto manifest,
-                   aruco::LoadFromTextProtoFile<aruco::proto::Context>(
+  ASSIGN_OR_RETURN(const std::vector<aruco::Context> contexts,
+                   aruco::LoadContextsFromTextProtoFile(
                        absl::GetFlag(FLAGS_manifest_path)));
-  const aruco::Context& context = aruco::ConvertContextFromProto(manifest);
+  ASSIGN_OR_RETURN(const cv::aruco::DetectorParameters detector_params,
+                   aruco::LoadDetectorParameters(
+                       absl::GetFlag(FLAGS_detector_params_path)));
+  const cv::aruco::ArucoDetector detector(
+      cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250),
+      detector_params);
 
   switch (file_type) {
     case kImage: {
-      RETURN_IF_ERROR(RunImage(calibration, context));
+      RETURN_IF_ERROR(RunImage(calibration, contexts, detector));
       break;
     }
     case kVideo: {
       cv::VideoCapture cap(file_path);
-      RETURN_IF_ERROR(RunVideo(calibration, context));
+      RETURN_IF_ERROR(RunVideo(cap, calibration, contexts, detector));
+      break;
+    }
+    case kRecording: {
+      const auto pacing = absl::GetFlag(FLAGS_replay_as_fast_as_possible)
+                              ? aruco::ReplayCapture::Pacing::kAsFastAsPossible
+                              : aruco::ReplayCapture::Pacing::kOriginal;
+      aruco::ReplayCapture cap(file_path, pacing);
+      RETURN_IF_ERROR(RunVideo(cap, calibration, contexts, detector));
       break;
     }
     case kUnknown:
@@ -192,7 +393,16 @@ int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   absl::ParseCommandLine(argc, argv);
   gflags::SetCommandLineOption("logtostderr", "1");
-  if (const auto status = Run(); !status.ok()) {
+  if (const std::string trace_path = absl::GetFlag(FLAGS_trace_path);
+      !trace_path.empty()) {
+    aruco::trace::Start(trace_path);
+    aruco::trace::SetThreadName("main");
+  }
+  const auto status = Run();
+  if (const auto trace_status = aruco::trace::Stop(); !trace_status.ok()) {
+    LOG(WARNING) << "Trace: " << trace_status.message();
+  }
+  if (!status.ok()) {
     LOG(ERROR) << "Failed: " << status.message();
     return EXIT_FAILURE;
   }
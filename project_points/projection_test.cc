@@ -11,6 +11,7 @@ namespace aruco {
 namespace {
 
 using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
 using ::bazel::tools::cpp::runfiles::Runfiles;
 
 TEST(ArucoDetection, Works) {
@@ -19,10 +20,24 @@ TEST(ArucoDetection, Works) {
       cv::imread(files->Rlocation("_main/testdata/frame_0.jpg"));
   ASSERT_FALSE(image.empty());
 
-  std::unordered_map<int32_t, cv::Point> results = DetectArucoPoints(
+  const DetectedMarkers results = DetectArucoPoints(
       image, cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250));
-  // TODO: Validate map
   ASSERT_THAT(results, testing::SizeIs(4));
+  // Marker centers of ids 1..4 measured by hand, tl, tr, br, bl.
+  const std::vector<cv::Point2f> expected_centers = {
+      {433, 149}, {1304, 167}, {1383, 876}, {421, 873}};
+  for (int32_t id = 1; id <= 4; ++id) {
+    ASSERT_TRUE(results.contains(id)) << id;
+    const DetectedMarker& marker = results.at(id);
+    EXPECT_LE(cv::norm(marker.center - expected_centers[id - 1]), 8.0) << id;
+    // Center lies within the marker outline.
+    EXPECT_GE(cv::pointPolygonTest(std::vector<cv::Point2f>(
+                                       marker.corners.begin(),
+                                       marker.corners.end()),
+                                   marker.center, /*measureDist=*/false),
+              0)
+        << id;
+  }
 }
 
 TEST(Projection, Works) {
@@ -49,5 +64,33 @@ TEST(Projection, Works) {
   EXPECT_THAT(image_points, testing::SizeIs(1));
 }
 
+TEST(Projection, BoundaryReprojectionError) {
+  const Runfiles* files = Runfiles::CreateForTest();
+  auto calibration_proto =
+      LoadFromTextProtoFile<aruco::proto::IntrinsicCalibration>(
+          files->Rlocation("_main/testdata/pixel_6a_calibration.txtpb"));
+  ASSERT_THAT(calibration_proto, IsOk());
+  auto manifest = LoadFromTextProtoFile<aruco::proto::Context>(
+      files->Rlocation("_main/testdata/simple_manifest.txtpb"));
+  ASSERT_THAT(manifest, IsOk());
+  const IntrinsicCalibration calibration =
+      ConvertIntrinsicCalibrationFromProto(*calibration_proto);
+  Context context = ConvertContextFromProto(*manifest);
+  const cv::Mat image =
+      cv::imread(files->Rlocation("_main/testdata/frame_0.jpg"));
+  ASSERT_FALSE(image.empty());
+
+  const DetectedMarkers markers = DetectArucoPoints(
+      image, cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250));
+  auto error = BoundaryReprojectionError(calibration, context, markers);
+  ASSERT_THAT(error, IsOk());
+  EXPECT_LT(*error, 2.0);
+
+  context.object_points.emplace_back(
+      ObjectPoint{.point = cv::Point3f(160, 300, 0), .tag = "extra"});
+  EXPECT_THAT(BoundaryReprojectionError(calibration, context, markers),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
 }  // namespace
 }  // namespace aruco
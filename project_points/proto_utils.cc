@@ -1,9 +1,44 @@
 #include "project_points/proto_utils.h"
+#include <google/protobuf/io/tokenizer.h>
 #include <google/protobuf/text_format.h>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 
 namespace aruco {
+namespace {
+
+// Keeps the first parse error instead of logging it.
+class FirstErrorCollector : public google::protobuf::io::ErrorCollector {
+ public:
+  void RecordError(int line, google::protobuf::io::ColumnNumber column,
+                   absl::string_view message) override {
+    if (error_.empty()) {
+      error_ = absl::StrCat("line ", line + 1, ":", column + 1, ": ", message);
+    }
+  }
+  const std::string& error() const { return error_; }
+
+ private:
+  std::string error_;
+};
+
+// Parses text into proto without logging. Returns the first error.
+absl::Status ParseTextProtoSilently(const std::string& text,
+                                    google::protobuf::Message& proto) {
+  FirstErrorCollector errors;
+  google::protobuf::TextFormat::Parser parser;
+  parser.RecordErrorsTo(&errors);
+  if (!parser.ParseFromString(text, &proto)) {
+    return absl::InvalidArgumentError(errors.error());
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
 
 IntrinsicCalibration ConvertIntrinsicCalibrationFromProto(
     const aruco::proto::IntrinsicCalibration& proto) {
@@ -37,6 +72,38 @@ IntrinsicCalibration ConvertIntrinsicCalibrationFromProto(
   return result;
 }
 
+aruco::proto::IntrinsicCalibration ConvertIntrinsicCalibrationToProto(
+    const IntrinsicCalibration& calibration) {
+  aruco::proto::IntrinsicCalibration proto;
+  cv::Mat camera_matrix;
+  calibration.camera_matrix.convertTo(camera_matrix, CV_64F);
+  proto.mutable_camera_matrix()->set_fx(camera_matrix.at<double>(0, 0));
+  proto.mutable_camera_matrix()->set_fy(camera_matrix.at<double>(1, 1));
+  proto.mutable_camera_matrix()->set_cx(camera_matrix.at<double>(0, 2));
+  proto.mutable_camera_matrix()->set_cy(camera_matrix.at<double>(1, 2));
+
+  cv::Mat distortion_params;
+  calibration.distortion_params.reshape(1, 1).convertTo(distortion_params,
+                                                        CV_64F);
+  aruco::proto::DistortionParams* params = proto.mutable_distortion_params();
+  using Setter = void (aruco::proto::DistortionParams::*)(float);
+  constexpr Setter kSetters[] = {
+      &aruco::proto::DistortionParams::set_k1,
+      &aruco::proto::DistortionParams::set_k2,
+      &aruco::proto::DistortionParams::set_k3,
+      &aruco::proto::DistortionParams::set_k4,
+      &aruco::proto::DistortionParams::set_k5,
+      &aruco::proto::DistortionParams::set_p1,
+      &aruco::proto::DistortionParams::set_p2,
+  };
+  const int32_t count =
+      std::min<int32_t>(distortion_params.cols, std::size(kSetters));
+  for (int32_t i = 0; i < count; ++i) {
+    (params->*kSetters[i])(distortion_params.at<double>(0, i));
+  }
+  return proto;
+}
+
 Context ConvertContextFromProto(const aruco::proto::Context& proto) {
   Context result;
   for (const auto& point : proto.points()) {
@@ -51,6 +118,144 @@ Context ConvertContextFromProto(const aruco::proto::Context& proto) {
             cv::Point3f(item_point.point().x(), item_point.point().y(),
                         item_point.point().z())});
   }
+  result.marker_ids.assign(proto.marker_ids().begin(),
+                           proto.marker_ids().end());
+  result.name = proto.name();
   return result;
 }
+
+cv::aruco::DetectorParameters ConvertDetectorParametersFromProto(
+    const aruco::proto::DetectorParams& proto) {
+  cv::aruco::DetectorParameters params;
+  if (proto.has_adaptive_thresh_win_size_min()) {
+    params.adaptiveThreshWinSizeMin = proto.adaptive_thresh_win_size_min();
+  }
+  if (proto.has_adaptive_thresh_win_size_max()) {
+    params.adaptiveThreshWinSizeMax = proto.adaptive_thresh_win_size_max();
+  }
+  if (proto.has_adaptive_thresh_win_size_step()) {
+    params.adaptiveThreshWinSizeStep = proto.adaptive_thresh_win_size_step();
+  }
+  if (proto.has_adaptive_thresh_constant()) {
+    params.adaptiveThreshConstant = proto.adaptive_thresh_constant();
+  }
+  if (proto.has_min_marker_perimeter_rate()) {
+    params.minMarkerPerimeterRate = proto.min_marker_perimeter_rate();
+  }
+  if (proto.has_max_marker_perimeter_rate()) {
+    params.maxMarkerPerimeterRate = proto.max_marker_perimeter_rate();
+  }
+  if (proto.has_polygonal_approx_accuracy_rate()) {
+    params.polygonalApproxAccuracyRate = proto.polygonal_approx_accuracy_rate();
+  }
+  if (proto.has_corner_refinement_method()) {
+    params.cornerRefinementMethod = static_cast<cv::aruco::CornerRefineMethod>(
+        proto.corner_refinement_method());
+  }
+  if (proto.has_corner_refinement_win_size()) {
+    params.cornerRefinementWinSize = proto.corner_refinement_win_size();
+  }
+  return params;
+}
+
+aruco::proto::DetectorParams ConvertDetectorParametersToProto(
+    const cv::aruco::DetectorParameters& params) {
+  aruco::proto::DetectorParams proto;
+  proto.set_adaptive_thresh_win_size_min(params.adaptiveThreshWinSizeMin);
+  proto.set_adaptive_thresh_win_size_max(params.adaptiveThreshWinSizeMax);
+  proto.set_adaptive_thresh_win_size_step(params.adaptiveThreshWinSizeStep);
+  proto.set_adaptive_thresh_constant(params.adaptiveThreshConstant);
+  proto.set_min_marker_perimeter_rate(params.minMarkerPerimeterRate);
+  proto.set_max_marker_perimeter_rate(params.maxMarkerPerimeterRate);
+  proto.set_polygonal_approx_accuracy_rate(params.polygonalApproxAccuracyRate);
+  proto.set_corner_refinement_method(
+      static_cast<aruco::proto::DetectorParams::CornerRefinement>(
+          params.cornerRefinementMethod));
+  proto.set_corner_refinement_win_size(params.cornerRefinementWinSize);
+  return proto;
+}
+
+absl::StatusOr<cv::aruco::DetectorParameters> LoadDetectorParameters(
+    absl::string_view file_path) {
+  if (file_path.empty()) return cv::aruco::DetectorParameters();
+  auto proto = LoadFromTextProtoFile<aruco::proto::DetectorParams>(file_path);
+  if (!proto.ok()) return proto.status();
+  const cv::aruco::DetectorParameters params =
+      ConvertDetectorParametersFromProto(*proto);
+  // OpenCV only asserts on these deep inside detectMarkers.
+  if (params.adaptiveThreshWinSizeMin < 3 ||
+      params.adaptiveThreshWinSizeMax < params.adaptiveThreshWinSizeMin ||
+      params.adaptiveThreshWinSizeStep <= 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Invalid adaptive threshold windows in ", file_path, ": min ",
+        params.adaptiveThreshWinSizeMin, ", max ",
+        params.adaptiveThreshWinSizeMax, ", step ",
+        params.adaptiveThreshWinSizeStep));
+  }
+  if (params.minMarkerPerimeterRate <= 0 ||
+      params.maxMarkerPerimeterRate <= params.minMarkerPerimeterRate ||
+      params.polygonalApproxAccuracyRate <= 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid marker perimeter or polygon rates in ",
+                     file_path));
+  }
+  return params;
+}
+
+absl::StatusOr<std::vector<Context>> ConvertStationFromProto(
+    const aruco::proto::Station& proto) {
+  std::vector<Context> contexts;
+  absl::flat_hash_set<int32_t> marker_ids;
+  for (const aruco::proto::Context& context_proto : proto.contexts()) {
+    Context context = ConvertContextFromProto(context_proto);
+    const std::string name =
+        context.name.empty() ? absl::StrCat("#", contexts.size())
+                             : context.name;
+    if (!context.marker_ids.empty() &&
+        context.marker_ids.size() != context.object_points.size()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Context ", name, " has ", context.marker_ids.size(),
+          " marker ids for ", context.object_points.size(), " points"));
+    }
+    for (size_t i = 0; i < context.object_points.size(); ++i) {
+      const int32_t id = BoundaryMarkerId(context, i);
+      if (!marker_ids.insert(id).second) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Marker id ", id, " of context ", name, " is used twice"));
+      }
+    }
+    contexts.push_back(std::move(context));
+  }
+  return contexts;
+}
+
+absl::StatusOr<std::vector<Context>> LoadContextsFromTextProtoFile(
+    absl::string_view file_path) {
+  std::ifstream file(file_path.data());
+  if (!file.is_open()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Failed to open file: ", file_path));
+  }
+  const std::string text((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  if (text.empty()) {
+    return absl::InvalidArgumentError(absl::StrCat("Empty file: ", file_path));
+  }
+
+  // Either message type may fail to parse, so neither attempt logs.
+  aruco::proto::Station station;
+  const absl::Status station_status = ParseTextProtoSilently(text, station);
+  if (station_status.ok()) return ConvertStationFromProto(station);
+  aruco::proto::Context context;
+  const absl::Status context_status = ParseTextProtoSilently(text, context);
+  if (!context_status.ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Failed to parse ", file_path, " as Station (",
+        station_status.message(), ") or as Context (",
+        context_status.message(), ")"));
+  }
+  aruco::proto::Station single;
+  *single.add_contexts() = std::move(context);
+  return ConvertStationFromProto(single);
+}
 }  // namespace aruco
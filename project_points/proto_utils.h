@@ -7,7 +7,9 @@
 #include "absl/strings/string_view.h"
 #include "google/protobuf/message.h"
 #include "project_points/projection.h"
+#include "opencv2/objdetect/aruco_detector.hpp"
 #include "project_points/proto/calibration_data.pb.h"
+#include "project_points/proto/detector_params.pb.h"
 #include "project_points/proto/manifest.pb.h"
 
 namespace aruco {
@@ -43,9 +45,39 @@ absl::StatusOr<ProtoType> LoadFromTextProtoFile(absl::string_view file_path) {
 IntrinsicCalibration ConvertIntrinsicCalibrationFromProto(
     const aruco::proto::IntrinsicCalibration& proto);
 
+// Converts struct into proto, the inverse of
+// ConvertIntrinsicCalibrationFromProto. Distortion coefficients fill
+// k1, k2, k3, k4, k5, p1, p2 in OpenCV order, so the common five are
+// k1, k2, p1, p2, k3. At most seven coefficients fit.
+aruco::proto::IntrinsicCalibration ConvertIntrinsicCalibrationToProto(
+    const IntrinsicCalibration& calibration);
+
 // Converts manifest proto into context
 Context ConvertContextFromProto(const aruco::proto::Context& proto);
 
+// Converts station proto into contexts. Fails if a context's marker ids
+// don't match its points or a marker id is used twice.
+absl::StatusOr<std::vector<Context>> ConvertStationFromProto(
+    const aruco::proto::Station& proto);
+
+// Loads a Station text proto, or a single Context text proto as a station
+// of one. Parse errors of both message types are returned, not logged.
+absl::StatusOr<std::vector<Context>> LoadContextsFromTextProtoFile(
+    absl::string_view file_path);
+
+// Converts proto into detector parameters. Unset fields keep the OpenCV
+// defaults.
+cv::aruco::DetectorParameters ConvertDetectorParametersFromProto(
+    const aruco::proto::DetectorParams& proto);
+
+// Converts the detector parameters DetectorParams covers into proto.
+aruco::proto::DetectorParams ConvertDetectorParametersToProto(
+    const cv::aruco::DetectorParameters& params);
+
+// Loads a DetectorParams text proto. Empty path gives the OpenCV defaults.
+absl::StatusOr<cv::aruco::DetectorParameters> LoadDetectorParameters(
+    absl::string_view file_path);
+
 // Writes proto to the text proto
 template <typename ProtoType>
 absl::StatusOr<std::string> WriteProtoToTextProto(ProtoType proto,
@@ -1,4 +1,7 @@
 #include "project_points/proto_utils.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include "absl/status/status_matchers.h"
 #include "gmock/gmock-matchers.h"
 #include "gtest/gtest.h"
@@ -10,6 +13,7 @@ namespace {
 
 using ::absl_testing::IsOk;
 using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
 using ::bazel::tools::cpp::runfiles::Runfiles;
 using ::protobuf_matchers::EqualsProto;
 using ::protobuf_matchers::Partially;
@@ -65,6 +69,19 @@ TEST(LoadFromTextProtoAndConvert, Works) {
               CompareMat(intrinsic.distortion_params, want_distortion_params));
 }
 
+TEST(ConvertIntrinsicCalibrationToProto, RoundTrips) {
+  const Runfiles* files = Runfiles::CreateForTest();
+  auto intrinsic_proto =
+      LoadFromTextProtoFile<aruco::proto::IntrinsicCalibration>(
+          files->Rlocation("_main/testdata/pixel_6a_calibration.txtpb"));
+  ASSERT_THAT(intrinsic_proto, IsOk());
+  intrinsic_proto->clear_reprojection_error();
+
+  EXPECT_THAT(ConvertIntrinsicCalibrationToProto(
+                  ConvertIntrinsicCalibrationFromProto(*intrinsic_proto)),
+              EqualsProto(*intrinsic_proto));
+}
+
 TEST(LoadFromTextManifestProto, Works) {
   const Runfiles* files = Runfiles::CreateForTest();
   const std::string text_proto_file_path =
@@ -104,5 +121,105 @@ TEST(ConvertContextFromProto, Works) {
    EXPECT_THAT(result.item_points, testing::SizeIs(1));
 }
 
+TEST(LoadContextsFromTextProtoFile, LoadsStation) {
+  const Runfiles* files = Runfiles::CreateForTest();
+  auto contexts = LoadContextsFromTextProtoFile(
+      files->Rlocation("_main/testdata/station_manifest.txtpb"));
+  ASSERT_THAT(contexts, IsOk());
+  ASSERT_THAT(*contexts, testing::SizeIs(2));
+  EXPECT_EQ(contexts->at(1).name, "tray_b");
+  EXPECT_THAT(contexts->at(1).marker_ids, testing::ElementsAre(5, 6, 7, 8));
+  EXPECT_THAT(contexts->at(1).item_points, testing::SizeIs(1));
+}
+
+TEST(LoadContextsFromTextProtoFile, LoadsSingleContext) {
+  const Runfiles* files = Runfiles::CreateForTest();
+  auto contexts = LoadContextsFromTextProtoFile(
+      files->Rlocation("_main/testdata/simple_manifest.txtpb"));
+  ASSERT_THAT(contexts, IsOk());
+  ASSERT_THAT(*contexts, testing::SizeIs(1));
+  EXPECT_THAT(contexts->at(0).marker_ids, testing::IsEmpty());
+  EXPECT_EQ(BoundaryMarkerId(contexts->at(0), 3), 4);
+}
+
+TEST(LoadContextsFromTextProtoFile, ReportsStationErrors) {
+  const std::string path =
+      (std::filesystem::path(std::getenv("TEST_TMPDIR")) / "station.txtpb")
+          .string();
+  {
+    std::ofstream file(path);
+    file << "contexts { name: \"tray_a\" marker_idz: 1 }\n";
+  }
+  EXPECT_THAT(LoadContextsFromTextProtoFile(path),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       testing::HasSubstr("marker_idz")));
+}
+
+TEST(ConvertStationFromProto, RejectsSharedMarkerIds) {
+  aruco::proto::Station station;
+  for (int32_t c = 0; c < 2; ++c) {
+    aruco::proto::Context* context = station.add_contexts();
+    for (int32_t i = 0; i < 4; ++i) context->add_points();
+  }
+  EXPECT_THAT(ConvertStationFromProto(station),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  for (int32_t id : {5, 6, 7, 8}) {
+    station.mutable_contexts(1)->add_marker_ids(id);
+  }
+  EXPECT_THAT(ConvertStationFromProto(station), IsOk());
+
+  station.mutable_contexts(1)->add_marker_ids(9);
+  EXPECT_THAT(ConvertStationFromProto(station),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ConvertDetectorParameters, RoundTrips) {
+  aruco::proto::DetectorParams proto;
+  proto.set_adaptive_thresh_win_size_min(7);
+  proto.set_adaptive_thresh_win_size_max(17);
+  proto.set_adaptive_thresh_win_size_step(5);
+  proto.set_min_marker_perimeter_rate(0.05);
+  proto.set_corner_refinement_method(
+      aruco::proto::DetectorParams::CORNER_REFINE_CONTOUR);
+
+  const cv::aruco::DetectorParameters params =
+      ConvertDetectorParametersFromProto(proto);
+  EXPECT_EQ(params.adaptiveThreshWinSizeMin, 7);
+  EXPECT_EQ(params.adaptiveThreshWinSizeMax, 17);
+  EXPECT_EQ(params.adaptiveThreshWinSizeStep, 5);
+  EXPECT_EQ(params.minMarkerPerimeterRate, 0.05);
+  EXPECT_EQ(params.cornerRefinementMethod, cv::aruco::CORNER_REFINE_CONTOUR);
+  // Unset fields keep the defaults.
+  EXPECT_EQ(params.maxMarkerPerimeterRate,
+            cv::aruco::DetectorParameters().maxMarkerPerimeterRate);
+
+  EXPECT_THAT(ConvertDetectorParametersToProto(params),
+              Partially(EqualsProto(proto)));
+}
+
+TEST(LoadDetectorParameters, ValidatesThresholdWindows) {
+  auto defaults = LoadDetectorParameters("");
+  ASSERT_THAT(defaults, IsOk());
+  EXPECT_EQ(defaults->adaptiveThreshWinSizeMax,
+            cv::aruco::DetectorParameters().adaptiveThreshWinSizeMax);
+
+  const std::string path =
+      (std::filesystem::path(std::getenv("TEST_TMPDIR")) / "params.txtpb")
+          .string();
+  aruco::proto::DetectorParams proto;
+  proto.set_adaptive_thresh_win_size_min(13);
+  proto.set_adaptive_thresh_win_size_max(13);
+  ASSERT_THAT(WriteProtoToTextProto(proto, path), IsOk());
+  auto params = LoadDetectorParameters(path);
+  ASSERT_THAT(params, IsOk());
+  EXPECT_EQ(params->adaptiveThreshWinSizeMin, 13);
+
+  proto.set_adaptive_thresh_win_size_max(7);
+  ASSERT_THAT(WriteProtoToTextProto(proto, path), IsOk());
+  EXPECT_THAT(LoadDetectorParameters(path),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 }  // namespace
 }  // namespace aruco
\ No newline at end of file
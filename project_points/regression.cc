@@ -0,0 +1,110 @@
+#include "project_points/regression.h"
+#include <algorithm>
+#include <limits>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+
+namespace aruco {
+
+PipelineResult RunPipeline(const cv::Mat& image,
+                           const IntrinsicCalibration& calibration,
+                           const Context& context,
+                           const cv::aruco::ArucoDetector& detector,
+                           int32_t repetitions) {
+  PipelineResult result;
+  result.latency_ms = std::numeric_limits<double>::max();
+  for (int32_t i = 0; i < std::max(1, repetitions); ++i) {
+    const int64_t start_ticks = cv::getTickCount();
+    result.marker_points = DetectArucoPoints(image, detector);
+    auto item_points =
+        ProjectItemPoints(calibration, context, result.marker_points);
+    const int64_t end_ticks = cv::getTickCount();
+    result.item_points =
+        item_points.ok() ? *std::move(item_points) : std::vector<cv::Point2f>();
+    result.latency_ms =
+        std::min(result.latency_ms,
+                 (end_ticks - start_ticks) / cv::getTickFrequency() * 1000.0);
+  }
+  // Outside of the timed section.
+  auto reprojection_error =
+      BoundaryReprojectionError(calibration, context, result.marker_points);
+  if (reprojection_error.ok()) {
+    result.reprojection_error_px = *reprojection_error;
+  }
+  return result;
+}
+
+std::vector<std::string> CompareWithGolden(const proto::GoldenImage& golden,
+                                           const PipelineResult& result,
+                                           const Context& context,
+                                           float pixel_tolerance) {
+  std::vector<std::string> mismatches;
+  if (golden.marker_points_size() !=
+      static_cast<int32_t>(result.marker_points.size())) {
+    mismatches.emplace_back(absl::StrCat(
+        "Want ", golden.marker_points_size(), " markers, got ",
+        result.marker_points.size()));
+  }
+  for (const proto::GoldenPoint& want : golden.marker_points()) {
+    if (!result.marker_points.contains(want.id())) {
+      mismatches.emplace_back(absl::StrCat("Marker ", want.id(), " is missing"));
+      continue;
+    }
+    const cv::Point2f got = result.marker_points.at(want.id()).center;
+    const double distance = cv::norm(got - cv::Point2f(want.x(), want.y()));
+    if (distance > pixel_tolerance) {
+      mismatches.emplace_back(absl::StrFormat(
+          "Marker %d moved %.1f px: want (%.1f, %.1f), got (%.1f, %.1f)",
+          want.id(), distance, want.x(), want.y(), got.x, got.y));
+    }
+  }
+
+  if (golden.item_points_size() !=
+      static_cast<int32_t>(result.item_points.size())) {
+    mismatches.emplace_back(absl::StrCat("Want ", golden.item_points_size(),
+                                         " item points, got ",
+                                         result.item_points.size()));
+    return mismatches;
+  }
+  for (int32_t i = 0; i < golden.item_points_size(); ++i) {
+    const proto::GoldenPoint& want = golden.item_points(i);
+    if (i < static_cast<int32_t>(context.item_points.size()) &&
+        context.item_points[i].id != want.id()) {
+      mismatches.emplace_back(absl::StrCat("Item point ", i, " want id ",
+                                           want.id(), ", manifest has ",
+                                           context.item_points[i].id));
+    }
+    const cv::Point2f& got = result.item_points[i];
+    const double distance = cv::norm(got - cv::Point2f(want.x(), want.y()));
+    if (distance > pixel_tolerance) {
+      mismatches.emplace_back(absl::StrFormat(
+          "Item %d moved %.1f px: want (%.1f, %.1f), got (%.1f, %.1f)",
+          want.id(), distance, want.x(), want.y(), got.x, got.y));
+    }
+  }
+  return mismatches;
+}
+
+proto::GoldenImage MakeGoldenImage(absl::string_view image_path,
+                                   const PipelineResult& result,
+                                   const Context& context) {
+  proto::GoldenImage golden;
+  golden.set_image_path(image_path);
+
+  for (const DetectedMarker& marker : result.marker_points) {
+    proto::GoldenPoint* point = golden.add_marker_points();
+    point->set_id(marker.id);
+    point->set_x(marker.center.x);
+    point->set_y(marker.center.y);
+  }
+
+  for (size_t i = 0; i < result.item_points.size(); ++i) {
+    proto::GoldenPoint* point = golden.add_item_points();
+    if (i < context.item_points.size()) point->set_id(context.item_points[i].id);
+    point->set_x(result.item_points[i].x);
+    point->set_y(result.item_points[i].y);
+  }
+  return golden;
+}
+
+}  // namespace aruco
@@ -0,0 +1,47 @@
+// Runs detection and projection and compares results with golden outputs.
+#ifndef REGRESSION_H
+#define REGRESSION_H
+#include <string>
+#include <vector>
+#include "absl/strings/string_view.h"
+#include "opencv2/core.hpp"
+#include "opencv2/objdetect/aruco_detector.hpp"
+#include "project_points/projection.h"
+#include "project_points/proto/golden.pb.h"
+
+namespace aruco {
+
+struct PipelineResult {
+  DetectedMarkers marker_points;
+  // Projected item points in the context order. Empty if the pose could not
+  // be recovered.
+  std::vector<cv::Point2f> item_points;
+  // PnP reprojection error of the boundary markers in pixels, -1 if the pose
+  // could not be recovered.
+  double reprojection_error_px = -1;
+  double latency_ms = 0;
+};
+
+// Detects markers and projects the context items. Latency is the best of
+// `repetitions` runs to suppress scheduler noise.
+PipelineResult RunPipeline(const cv::Mat& image,
+                           const IntrinsicCalibration& calibration,
+                           const Context& context,
+                           const cv::aruco::ArucoDetector& detector,
+                           int32_t repetitions = 1);
+
+// Returns mismatches between golden and actual result as human readable
+// messages. Empty means the result matches.
+std::vector<std::string> CompareWithGolden(const proto::GoldenImage& golden,
+                                           const PipelineResult& result,
+                                           const Context& context,
+                                           float pixel_tolerance);
+
+// Builds golden entry from the result.
+proto::GoldenImage MakeGoldenImage(absl::string_view image_path,
+                                   const PipelineResult& result,
+                                   const Context& context);
+
+}  // namespace aruco
+
+#endif  // REGRESSION_H
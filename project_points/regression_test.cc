@@ -0,0 +1,206 @@
+// Gates accuracy and latency of detection plus projection against golden
+// results in testdata/golden_results.txtpb. Regenerate the goldens with
+// bazel run //project_points:golden_main
+// Latency budget can be overridden with
+// bazel test --test_env=ARUCO_LATENCY_BUDGET_MS=50 //project_points:regression_test
+#include "project_points/regression.h"
+#include <cstdlib>
+#include <filesystem>
+#include <unordered_set>
+#include "absl/status/status_matchers.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+#include "opencv2/imgcodecs.hpp"
+#include "project_points/highgui_utils.h"
+#include "project_points/proto_utils.h"
+#include "project_points/synthetic_scene.h"
+#include "tools/cpp/runfiles/runfiles.h"
+
+namespace aruco {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::bazel::tools::cpp::runfiles::Runfiles;
+
+class RegressionTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    files_.reset(Runfiles::CreateForTest());
+    auto golden = LoadFromTextProtoFile<proto::GoldenResults>(
+        Location("testdata/golden_results.txtpb"));
+    ASSERT_THAT(golden, IsOk());
+    golden_ = *std::move(golden);
+
+    auto calibration_proto =
+        LoadFromTextProtoFile<proto::IntrinsicCalibration>(
+            Location(golden_.calibration_path()));
+    ASSERT_THAT(calibration_proto, IsOk());
+    calibration_ = ConvertIntrinsicCalibrationFromProto(*calibration_proto);
+
+    auto manifest = LoadFromTextProtoFile<proto::Context>(
+        Location(golden_.manifest_path()));
+    ASSERT_THAT(manifest, IsOk());
+    context_ = ConvertContextFromProto(*manifest);
+
+    auto detector_params = LoadDetectorParameters(
+        golden_.detector_params_path().empty()
+            ? ""
+            : Location(golden_.detector_params_path()));
+    ASSERT_THAT(detector_params, IsOk());
+    detector_ = cv::aruco::ArucoDetector(
+        cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250),
+        *detector_params);
+
+    latency_budget_ms_ = golden_.latency_budget_ms();
+    if (const char* budget = std::getenv("ARUCO_LATENCY_BUDGET_MS");
+        budget != nullptr) {
+      ASSERT_TRUE(absl::SimpleAtof(budget, &latency_budget_ms_)) << budget;
+    }
+  }
+
+  std::string Location(absl::string_view workspace_path) const {
+    return files_->Rlocation(absl::StrCat("_main/", workspace_path));
+  }
+
+  std::unique_ptr<Runfiles> files_;
+  proto::GoldenResults golden_;
+  IntrinsicCalibration calibration_;
+  Context context_;
+  float latency_budget_ms_ = 0;
+  cv::aruco::ArucoDetector detector_;
+};
+
+TEST_F(RegressionTest, MatchesGolden) {
+  // Without images the gate would pass without checking anything.
+  ASSERT_GT(golden_.images_size(), 0)
+      << "Run bazel run //project_points:golden_main";
+  for (const proto::GoldenImage& golden_image : golden_.images()) {
+    SCOPED_TRACE(golden_image.image_path());
+    const cv::Mat image = cv::imread(Location(golden_image.image_path()));
+    ASSERT_FALSE(image.empty());
+
+    const PipelineResult result =
+        RunPipeline(image, calibration_, context_, detector_,
+                    golden_.latency_repetitions());
+    EXPECT_THAT(CompareWithGolden(golden_image, result, context_,
+                                  golden_.pixel_tolerance()),
+                testing::IsEmpty());
+
+    const float budget_ms = golden_image.has_latency_budget_ms()
+                                ? golden_image.latency_budget_ms()
+                                : latency_budget_ms_;
+    EXPECT_LE(result.latency_ms, budget_ms);
+    RecordProperty(golden_image.image_path(),
+                   absl::StrFormat("%.2f ms", result.latency_ms));
+  }
+}
+
+TEST_F(RegressionTest, AllImagesHaveGolden) {
+  std::unordered_set<std::string> golden_paths;
+  for (const proto::GoldenImage& golden_image : golden_.images()) {
+    golden_paths.insert(golden_image.image_path());
+  }
+  const std::filesystem::path testdata = Location("testdata");
+  std::vector<std::string> missing;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(
+           testdata,
+           std::filesystem::directory_options::follow_directory_symlink)) {
+    if (GetFileType(entry.path().string()) != FileType::kImage) continue;
+    const std::string path =
+        entry.path().lexically_relative(testdata.parent_path()).string();
+    if (!golden_paths.contains(path)) missing.push_back(path);
+  }
+  std::sort(missing.begin(), missing.end());
+  EXPECT_THAT(missing, testing::IsEmpty())
+      << "No golden results for " << absl::StrJoin(missing, ", ")
+      << ". Run bazel run //project_points:golden_main";
+}
+
+// Synthetic frames have exact ground truth, so they gate accuracy without
+// golden files.
+TEST_F(RegressionTest, SyntheticMatchesGroundTruth) {
+  SceneOptions options;
+  options.noise_stddev = 3;
+  options.blur_sigma = 0.7;
+  auto generator =
+      SyntheticSceneGenerator::Create(calibration_, context_, options);
+  ASSERT_THAT(generator, IsOk());
+
+  constexpr int32_t kFrames = 8;
+  constexpr float kTolerance = 4.0;
+  for (const SyntheticFrame& frame : generator->RenderBatch(0, kFrames)) {
+    SCOPED_TRACE(absl::StrCat("Frame ", frame.frame_index));
+    const PipelineResult result =
+        RunPipeline(frame.image, generator->calibration(), context_,
+                    detector_, golden_.latency_repetitions());
+
+    ASSERT_EQ(result.marker_points.size(), frame.marker_points.size());
+    for (size_t i = 0; i < frame.marker_points.size(); ++i) {
+      const int32_t id = static_cast<int32_t>(i + 1);
+      ASSERT_TRUE(result.marker_points.contains(id)) << id;
+      EXPECT_LE(cv::norm(result.marker_points.at(id).center -
+                         frame.marker_points[i]),
+                kTolerance)
+          << "Marker " << id;
+    }
+    ASSERT_EQ(result.item_points.size(), frame.item_points.size());
+    for (size_t i = 0; i < frame.item_points.size(); ++i) {
+      EXPECT_LE(cv::norm(result.item_points[i] - frame.item_points[i]),
+                kTolerance)
+          << "Item " << i;
+    }
+    EXPECT_LE(result.latency_ms, latency_budget_ms_);
+  }
+}
+
+// Integer bounding box centers, as detection used to report them.
+DetectedMarkers WithIntegerCenters(const DetectedMarkers& markers) {
+  DetectedMarkers rounded;
+  for (DetectedMarker marker : markers) {
+    const cv::Rect bbox = cv::boundingRect(std::vector<cv::Point2f>(
+        marker.corners.begin(), marker.corners.end()));
+    marker.center = (bbox.tl() + bbox.br()) / 2;
+    rounded.Insert(marker);
+  }
+  return rounded;
+}
+
+// Diagonal intersection centers of the detected corners against integer
+// bounding box centers.
+TEST_F(RegressionTest, DiagonalCentersReduceReprojectionError) {
+  SceneOptions options;
+  options.noise_stddev = 3;
+  options.blur_sigma = 0.7;
+  auto generator =
+      SyntheticSceneGenerator::Create(calibration_, context_, options);
+  ASSERT_THAT(generator, IsOk());
+
+  constexpr int32_t kFrames = 8;
+  double diagonal_error = 0;
+  double integer_error = 0;
+  for (const SyntheticFrame& frame : generator->RenderBatch(0, kFrames)) {
+    SCOPED_TRACE(absl::StrCat("Frame ", frame.frame_index));
+    const DetectedMarkers markers = DetectArucoPoints(frame.image, detector_);
+    auto error =
+        BoundaryReprojectionError(generator->calibration(), context_, markers);
+    ASSERT_THAT(error, IsOk());
+    auto rounded_error = BoundaryReprojectionError(
+        generator->calibration(), context_, WithIntegerCenters(markers));
+    ASSERT_THAT(rounded_error, IsOk());
+    diagonal_error += *error / kFrames;
+    integer_error += *rounded_error / kFrames;
+  }
+  RecordProperty("diagonal_reprojection_error_px",
+                 absl::StrFormat("%.3f", diagonal_error));
+  RecordProperty("integer_reprojection_error_px",
+                 absl::StrFormat("%.3f", integer_error));
+  EXPECT_LT(diagonal_error, integer_error);
+  EXPECT_LT(diagonal_error, 1.0);
+}
+
+}  // namespace
+}  // namespace aruco
@@ -0,0 +1,171 @@
+#include "project_points/shm_channel.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+#include "absl/strings/str_cat.h"
+
+namespace aruco {
+namespace {
+
+constexpr uint32_t kMagic = 0x41534d43;  // "ASMC"
+
+uint64_t Align(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+uint64_t HeaderSize() { return Align(sizeof(ShmChannelHeader), 4096); }
+
+uint64_t SegmentSize(const ShmChannelHeader& header) {
+  return HeaderSize() +
+         header.slot_count *
+             (header.frame_slot_stride + header.result_slot_stride);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<ShmChannel>> ShmChannel::Create(
+    absl::string_view name, uint32_t slot_count, uint64_t max_frame_bytes) {
+  if (name.empty() || name.front() != '/') {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Shared memory name must start with /: ", name));
+  }
+  if (slot_count == 0 || max_frame_bytes == 0) {
+    return absl::InvalidArgumentError("Slot count and size must be positive");
+  }
+  const std::string shm_name(name);
+  ::shm_unlink(shm_name.c_str());
+  const int fd = ::shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return absl::InternalError(
+        absl::StrCat("shm_open ", name, ": ", std::strerror(errno)));
+  }
+
+  ShmChannelHeader layout;
+  layout.slot_count = slot_count;
+  layout.max_frame_bytes = max_frame_bytes;
+  // Page aligned frames keep pixel rows nicely aligned for SIMD.
+  layout.frame_slot_stride =
+      Align(kShmFrameDataOffset + max_frame_bytes, 4096);
+  layout.result_slot_stride = Align(sizeof(ShmResultSlot), 64);
+  const uint64_t size = SegmentSize(layout);
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    const std::string error = std::strerror(errno);
+    ::close(fd);
+    ::shm_unlink(shm_name.c_str());
+    return absl::InternalError(absl::StrCat("ftruncate ", name, ": ", error));
+  }
+  void* data =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    ::shm_unlink(shm_name.c_str());
+    return absl::InternalError(
+        absl::StrCat("mmap ", name, ": ", std::strerror(errno)));
+  }
+
+  std::unique_ptr<ShmChannel> channel(new ShmChannel());
+  channel->name_ = shm_name;
+  channel->data_ = static_cast<uint8_t*>(data);
+  channel->size_ = size;
+  channel->owner_ = true;
+
+  ShmChannelHeader* header = new (data) ShmChannelHeader();
+  header->slot_count = layout.slot_count;
+  header->max_frame_bytes = layout.max_frame_bytes;
+  header->frame_slot_stride = layout.frame_slot_stride;
+  header->result_slot_stride = layout.result_slot_stride;
+  header->owner_pid.store(0, std::memory_order_relaxed);
+  header->request_head.store(0, std::memory_order_relaxed);
+  header->request_tail.store(0, std::memory_order_relaxed);
+  header->result_head.store(0, std::memory_order_relaxed);
+  header->result_tail.store(0, std::memory_order_relaxed);
+  header->magic.store(kMagic, std::memory_order_release);
+  return channel;
+}
+
+absl::StatusOr<std::unique_ptr<ShmChannel>> ShmChannel::Open(
+    absl::string_view name) {
+  const std::string shm_name(name);
+  const int fd = ::shm_open(shm_name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return absl::NotFoundError(
+        absl::StrCat("shm_open ", name, ": ", std::strerror(errno)));
+  }
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0 ||
+      static_cast<uint64_t>(file_stat.st_size) < HeaderSize()) {
+    ::close(fd);
+    return absl::UnavailableError(absl::StrCat(name, " is not initialized"));
+  }
+  const size_t size = static_cast<size_t>(file_stat.st_size);
+  void* data =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return absl::InternalError(
+        absl::StrCat("mmap ", name, ": ", std::strerror(errno)));
+  }
+
+  std::unique_ptr<ShmChannel> channel(new ShmChannel());
+  channel->name_ = shm_name;
+  channel->data_ = static_cast<uint8_t*>(data);
+  channel->size_ = size;
+  if (channel->header().magic.load(std::memory_order_acquire) != kMagic ||
+      SegmentSize(channel->header()) != size) {
+    return absl::UnavailableError(absl::StrCat(name, " is not initialized"));
+  }
+  return channel;
+}
+
+ShmChannel::~ShmChannel() {
+  if (data_ != nullptr) ::munmap(data_, size_);
+  if (owner_) ::shm_unlink(name_.c_str());
+}
+
+ShmFrameSlot& ShmChannel::frame_slot(uint64_t sequence) const {
+  const ShmChannelHeader& h = header();
+  return *reinterpret_cast<ShmFrameSlot*>(
+      data_ + HeaderSize() + (sequence % h.slot_count) * h.frame_slot_stride);
+}
+
+uint8_t* ShmChannel::frame_data(uint64_t sequence) const {
+  return reinterpret_cast<uint8_t*>(&frame_slot(sequence)) +
+         kShmFrameDataOffset;
+}
+
+ShmResultSlot& ShmChannel::result_slot(uint64_t sequence) const {
+  const ShmChannelHeader& h = header();
+  return *reinterpret_cast<ShmResultSlot*>(
+      data_ + HeaderSize() + h.slot_count * h.frame_slot_stride +
+      (sequence % h.slot_count) * h.result_slot_stride);
+}
+
+std::string ShmChannelName(absl::string_view prefix, int32_t index) {
+  return absl::StrCat(prefix, ".", index);
+}
+
+int64_t MonotonicNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void Backoff::Wait() {
+  if (spins_ < 1024) ++spins_;
+  if (spins_ < 64) return;
+  if (spins_ < 128) {
+    std::this_thread::yield();
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(
+      std::min<int32_t>(200, (spins_ - 128) * 10 + 10)));
+}
+
+}  // namespace aruco
@@ -0,0 +1,138 @@
+// POSIX shared memory channel between one client and the detection daemon.
+//
+// The segment holds a header and two single producer single consumer rings
+// with slot_count slots each:
+//   request ring: client writes frames in place, daemon reads them in place,
+//   result ring: daemon writes detections and projected item points.
+// Ring positions are monotonic counters. Producer publishes a slot with a
+// release store of its head, consumer frees it with a release store of its
+// tail. No locks and no copies of the frame.
+#ifndef SHM_CHANNEL_H
+#define SHM_CHANNEL_H
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "project_points/detected_markers.h"
+
+namespace aruco {
+
+inline constexpr int32_t kMaxShmItems = 256;
+
+struct ShmPoint {
+  int32_t id;
+  float x;
+  float y;
+};
+
+struct ShmChannelHeader {
+  // Set last by the daemon once the segment is initialized.
+  std::atomic<uint32_t> magic;
+  uint32_t slot_count;
+  uint64_t max_frame_bytes;
+  uint64_t frame_slot_stride;
+  uint64_t result_slot_stride;
+  // Pid of the client that owns the channel, 0 if free.
+  std::atomic<int32_t> owner_pid;
+  // Written by the client
+  alignas(64) std::atomic<uint64_t> request_head;
+  // Written by the daemon
+  alignas(64) std::atomic<uint64_t> request_tail;
+  // Written by the daemon
+  alignas(64) std::atomic<uint64_t> result_head;
+  // Written by the client
+  alignas(64) std::atomic<uint64_t> result_tail;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(std::atomic<int32_t>::is_always_lock_free);
+
+// Pixel data follows the slot header at kShmFrameDataOffset.
+struct ShmFrameSlot {
+  uint64_t sequence;
+  // Steady clock time of submission, echoed in the result.
+  int64_t submit_ns;
+  int32_t rows;
+  int32_t cols;
+  int32_t type;
+  int32_t reserved;
+  uint64_t step;
+};
+
+inline constexpr uint64_t kShmFrameDataOffset = 64;
+static_assert(sizeof(ShmFrameSlot) <= kShmFrameDataOffset);
+
+struct ShmResultSlot {
+  uint64_t sequence;
+  int64_t submit_ns;
+  // Time the daemon spent on the frame.
+  int64_t processing_ns;
+  // absl::StatusCode of the frame. Markers are valid unless the frame was
+  // invalid, items only if it is OK.
+  int32_t status_code;
+  int32_t item_count;
+  DetectedMarkers markers;
+  ShmPoint items[kMaxShmItems];
+};
+
+static_assert(std::is_trivially_copyable_v<DetectedMarkers>);
+
+class ShmChannel {
+ public:
+  // Creates the segment, replacing a stale one with the same name. It is
+  // unlinked when the returned channel is destroyed. Name must start with /.
+  static absl::StatusOr<std::unique_ptr<ShmChannel>> Create(
+      absl::string_view name, uint32_t slot_count, uint64_t max_frame_bytes);
+
+  // Maps an existing, initialized segment.
+  static absl::StatusOr<std::unique_ptr<ShmChannel>> Open(
+      absl::string_view name);
+
+  ShmChannel(const ShmChannel&) = delete;
+  ShmChannel& operator=(const ShmChannel&) = delete;
+  ~ShmChannel();
+
+  ShmChannelHeader& header() const {
+    return *reinterpret_cast<ShmChannelHeader*>(data_);
+  }
+  uint32_t slot_count() const { return header().slot_count; }
+  uint64_t max_frame_bytes() const { return header().max_frame_bytes; }
+
+  // Slots for ring position `sequence`.
+  ShmFrameSlot& frame_slot(uint64_t sequence) const;
+  uint8_t* frame_data(uint64_t sequence) const;
+  ShmResultSlot& result_slot(uint64_t sequence) const;
+
+  const std::string& name() const { return name_; }
+
+ private:
+  ShmChannel() = default;
+
+  std::string name_;
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  bool owner_ = false;
+};
+
+// Name of the i-th channel of a daemon.
+std::string ShmChannelName(absl::string_view prefix, int32_t index);
+
+// Steady clock in nanoseconds, comparable between processes.
+int64_t MonotonicNowNs();
+
+// Busy-waits with growing pauses, for polling the rings.
+class Backoff {
+ public:
+  void Wait();
+  void Reset() { spins_ = 0; }
+
+ private:
+  int32_t spins_ = 0;
+};
+
+}  // namespace aruco
+
+#endif  // SHM_CHANNEL_H
@@ -0,0 +1,252 @@
+#include "project_points/synthetic_scene.h"
+#include <algorithm>
+#include <cmath>
+#include "absl/strings/str_cat.h"
+#include "opencv2/calib3d.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/objdetect/aruco_detector.hpp"
+
+namespace aruco {
+namespace {
+
+// Colors are BGR. Something like a light wooden table.
+const cv::Scalar kBackground(160, 200, 225);
+const cv::Scalar kItem(130, 230, 240);
+
+constexpr double kDegrees = CV_PI / 180.0;
+
+cv::Matx33d RotationFromEuler(double rx, double ry, double rz) {
+  const cv::Matx33d x(1, 0, 0, 0, std::cos(rx), -std::sin(rx), 0, std::sin(rx),
+                      std::cos(rx));
+  const cv::Matx33d y(std::cos(ry), 0, std::sin(ry), 0, 1, 0, -std::sin(ry), 0,
+                      std::cos(ry));
+  const cv::Matx33d z(std::cos(rz), -std::sin(rz), 0, std::sin(rz),
+                      std::cos(rz), 0, 0, 0, 1);
+  return z * y * x;
+}
+
+}  // namespace
+
+absl::StatusOr<SyntheticSceneGenerator> SyntheticSceneGenerator::Create(
+    const IntrinsicCalibration& calibration, const Context& context,
+    const SceneOptions& options, const cv::aruco::Dictionary& dictionary) {
+  if (context.object_points.size() < 4) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Context needs at least four object points, got ",
+                     context.object_points.size()));
+  }
+  for (const ObjectPoint& object_point : context.object_points) {
+    if (object_point.point.z != 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Object point '", object_point.tag, "' is not planar"));
+    }
+  }
+  if (options.image_size.empty() || options.calibration_size.empty()) {
+    return absl::InvalidArgumentError("Image sizes must not be empty");
+  }
+  if (options.marker_size <= 0 || options.pixels_per_unit <= 0) {
+    return absl::InvalidArgumentError(
+        "Marker size and pixels per unit must be positive");
+  }
+
+  SyntheticSceneGenerator generator;
+  generator.context_ = context;
+  generator.options_ = options;
+
+  // Scale camera matrix to the output resolution.
+  const double scale_x = static_cast<double>(options.image_size.width) /
+                         options.calibration_size.width;
+  const double scale_y = static_cast<double>(options.image_size.height) /
+                         options.calibration_size.height;
+  generator.calibration_.camera_matrix = calibration.camera_matrix.clone();
+  generator.calibration_.camera_matrix.at<double>(0, 0) *= scale_x;
+  generator.calibration_.camera_matrix.at<double>(0, 2) *= scale_x;
+  generator.calibration_.camera_matrix.at<double>(1, 1) *= scale_y;
+  generator.calibration_.camera_matrix.at<double>(1, 2) *= scale_y;
+  generator.calibration_.distortion_params =
+      calibration.distortion_params.clone();
+
+  // Tray texture. Markers are centered on the object points, so leave one
+  // marker of margin around the boundary which also serves as quiet zone.
+  float min_x = context.object_points[0].point.x;
+  float max_x = min_x;
+  float min_y = context.object_points[0].point.y;
+  float max_y = min_y;
+  for (const ObjectPoint& object_point : context.object_points) {
+    min_x = std::min(min_x, object_point.point.x);
+    max_x = std::max(max_x, object_point.point.x);
+    min_y = std::min(min_y, object_point.point.y);
+    max_y = std::max(max_y, object_point.point.y);
+  }
+  const float margin = options.marker_size;
+  const float ppu = options.pixels_per_unit;
+  generator.tray_center_ =
+      cv::Point2f((min_x + max_x) / 2.0f, (min_y + max_y) / 2.0f);
+  generator.tray_extent_ = cv::Size2f(max_x - min_x + options.marker_size,
+                                      max_y - min_y + options.marker_size);
+  generator.context_to_texture_ =
+      cv::Matx33d(ppu, 0, (margin - min_x) * ppu, 0, ppu,
+                  (margin - min_y) * ppu, 0, 0, 1);
+  generator.texture_ = cv::Mat(
+      cv::Size(static_cast<int>(std::ceil((max_x - min_x + 2 * margin) * ppu)),
+               static_cast<int>(std::ceil((max_y - min_y + 2 * margin) * ppu))),
+      CV_8UC3, kBackground);
+
+  auto to_texture = [&generator](const cv::Point3f& point) {
+    const cv::Vec3d p = generator.context_to_texture_ *
+                        cv::Vec3d(point.x, point.y, 1.0);
+    return cv::Point2f(p[0], p[1]);
+  };
+
+  for (const ItemObjectPoint& item_point : context.item_points) {
+    const cv::Point2f center = to_texture(item_point.object_point);
+    const float half = options.marker_size * ppu / 2;
+    cv::rectangle(generator.texture_,
+                  cv::Point(center.x - half, center.y - half),
+                  cv::Point(center.x + half, center.y + half), kItem,
+                  cv::FILLED);
+  }
+
+  const int32_t marker_pixels =
+      static_cast<int32_t>(std::round(options.marker_size * ppu));
+  for (size_t i = 0; i < context.object_points.size(); ++i) {
+    cv::Mat marker;
+    cv::aruco::generateImageMarker(dictionary, BoundaryMarkerId(context, i),
+                                   marker_pixels, marker, /*borderBits=*/1);
+    cv::cvtColor(marker, marker, cv::COLOR_GRAY2BGR);
+    const cv::Point2f center = to_texture(context.object_points[i].point);
+    const cv::Rect roi(static_cast<int>(std::round(center.x)) - marker_pixels / 2,
+                       static_cast<int>(std::round(center.y)) - marker_pixels / 2,
+                       marker_pixels, marker_pixels);
+    marker.copyTo(generator.texture_(roi));
+  }
+
+  // Undistorted normalized coordinates of every output pixel. It only depends
+  // on the calibration, so warping a frame is a homography plus remap.
+  const cv::Size size = options.image_size;
+  cv::Mat pixels(size.area(), 1, CV_32FC2);
+  for (int32_t y = 0; y < size.height; ++y) {
+    for (int32_t x = 0; x < size.width; ++x) {
+      pixels.at<cv::Vec2f>(y * size.width + x) = cv::Vec2f(x, y);
+    }
+  }
+  cv::Mat normalized;
+  cv::undistortPoints(
+      pixels, normalized, generator.calibration_.camera_matrix,
+      generator.calibration_.distortion_params, cv::noArray(), cv::noArray(),
+      cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20,
+                       1e-6));
+  generator.normalized_map_ = normalized.reshape(2, size.height);
+
+  return generator;
+}
+
+SyntheticFrame SyntheticSceneGenerator::Render(int64_t frame_index) const {
+  cv::RNG rng(options_.seed * 0x9E3779B97F4A7C15ULL +
+              static_cast<uint64_t>(frame_index) + 1);
+  SyntheticFrame frame;
+  frame.frame_index = frame_index;
+
+  // Random pose
+  const double max_tilt = options_.max_tilt_degrees * kDegrees;
+  const double max_roll = options_.max_roll_degrees * kDegrees;
+  const cv::Matx33d rotation =
+      RotationFromEuler(rng.uniform(-max_tilt, max_tilt),
+                        rng.uniform(-max_tilt, max_tilt),
+                        rng.uniform(-max_roll, max_roll));
+
+  const cv::Matx33d camera_matrix(calibration_.camera_matrix);
+  const double fx = camera_matrix(0, 0);
+  const double fy = camera_matrix(1, 1);
+  const double cx = camera_matrix(0, 2);
+  const double cy = camera_matrix(1, 2);
+  const double width = options_.image_size.width;
+  const double height = options_.image_size.height;
+
+  const double coverage =
+      rng.uniform(options_.min_coverage, options_.max_coverage);
+  const double distance = std::max(fx * tray_extent_.width / (coverage * width),
+                                   fy * tray_extent_.height / (coverage * height));
+  // Tray center lands around the image center (not the principal point).
+  const double slack = (1.0 - coverage) / 4.0;
+  const double target_u = width / 2 + rng.uniform(-slack, slack) * width;
+  const double target_v = height / 2 + rng.uniform(-slack, slack) * height;
+  const cv::Vec3d target((target_u - cx) / fx * distance,
+                         (target_v - cy) / fy * distance, distance);
+  const cv::Vec3d translation =
+      target - rotation * cv::Vec3d(tray_center_.x, tray_center_.y, 0);
+  cv::Rodrigues(rotation, frame.rvec);
+  frame.tvec = translation;
+
+  // Context plane to normalized camera coordinates is [r1 r2 t]. Invert it
+  // to look up the texture for every output pixel.
+  const cv::Matx33d plane_to_normalized(
+      rotation(0, 0), rotation(0, 1), translation[0], rotation(1, 0),
+      rotation(1, 1), translation[1], rotation(2, 0), rotation(2, 1),
+      translation[2]);
+  const cv::Matx33d normalized_to_texture =
+      context_to_texture_ * plane_to_normalized.inv();
+  cv::Mat texture_map;
+  cv::perspectiveTransform(normalized_map_, texture_map, normalized_to_texture);
+  cv::remap(texture_, frame.image, texture_map, cv::noArray(), cv::INTER_LINEAR,
+            cv::BORDER_CONSTANT, kBackground);
+
+  if (options_.blur_sigma > 0) {
+    cv::GaussianBlur(frame.image, frame.image, cv::Size(0, 0),
+                     options_.blur_sigma);
+  }
+  if (options_.noise_stddev > 0) {
+    cv::Mat noise(frame.image.size(), CV_16SC3);
+    rng.fill(noise, cv::RNG::NORMAL, 0.0, options_.noise_stddev);
+    cv::Mat noisy;
+    frame.image.convertTo(noisy, CV_16SC3);
+    noisy += noise;
+    noisy.convertTo(frame.image, CV_8UC3);
+  }
+
+  // Ground truth
+  std::vector<cv::Point3f> marker_object_points;
+  const float half = options_.marker_size / 2;
+  for (const ObjectPoint& object_point : context_.object_points) {
+    const cv::Point3f& p = object_point.point;
+    marker_object_points.emplace_back(p);
+    marker_object_points.emplace_back(p.x - half, p.y - half, 0);
+    marker_object_points.emplace_back(p.x + half, p.y - half, 0);
+    marker_object_points.emplace_back(p.x + half, p.y + half, 0);
+    marker_object_points.emplace_back(p.x - half, p.y + half, 0);
+  }
+  std::vector<cv::Point2f> marker_image_points;
+  cv::projectPoints(marker_object_points, frame.rvec, frame.tvec,
+                    calibration_.camera_matrix, calibration_.distortion_params,
+                    marker_image_points);
+  for (size_t i = 0; i < marker_image_points.size(); i += 5) {
+    frame.marker_points.emplace_back(marker_image_points[i]);
+    frame.marker_corners.emplace_back(marker_image_points.begin() + i + 1,
+                                      marker_image_points.begin() + i + 5);
+  }
+
+  if (!context_.item_points.empty()) {
+    std::vector<cv::Point3f> item_object_points;
+    for (const ItemObjectPoint& item_point : context_.item_points) {
+      item_object_points.emplace_back(item_point.object_point);
+    }
+    cv::projectPoints(item_object_points, frame.rvec, frame.tvec,
+                      calibration_.camera_matrix,
+                      calibration_.distortion_params, frame.item_points);
+  }
+
+  return frame;
+}
+
+std::vector<SyntheticFrame> SyntheticSceneGenerator::RenderBatch(
+    int64_t first_frame_index, int32_t count) const {
+  std::vector<SyntheticFrame> frames(count);
+  cv::parallel_for_(cv::Range(0, count), [&](const cv::Range& range) {
+    for (int32_t i = range.start; i < range.end; ++i) {
+      frames[i] = Render(first_frame_index + i);
+    }
+  });
+  return frames;
+}
+
+}  // namespace aruco
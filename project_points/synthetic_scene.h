@@ -0,0 +1,94 @@
+// Renders synthetic frames of a context (tray) with Aruco boundary markers
+// seen through a calibrated camera. Used for load and accuracy benchmarking.
+#ifndef SYNTHETIC_SCENE_H
+#define SYNTHETIC_SCENE_H
+#include <vector>
+#include "absl/status/statusor.h"
+#include "opencv2/core.hpp"
+#include "opencv2/objdetect/aruco_dictionary.hpp"
+#include "project_points/projection.h"
+
+namespace aruco {
+
+struct SceneOptions {
+  // Size of the rendered frames.
+  cv::Size image_size = cv::Size(1920, 1080);
+  // Resolution the intrinsic calibration belongs to. The camera matrix is
+  // scaled from it to image_size.
+  cv::Size calibration_size = cv::Size(1920, 1080);
+  // Side of the boundary markers in context units. Markers are centered on
+  // the context object points.
+  float marker_size = 40;
+  // Resolution of the tray texture the frames are warped from.
+  float pixels_per_unit = 4;
+  // Range of the tray width or height as a fraction of the frame.
+  double min_coverage = 0.4;
+  double max_coverage = 0.8;
+  // Maximum out-of-plane rotation. Keep it moderate so that every ray hits
+  // the tray plane in front of the camera.
+  double max_tilt_degrees = 25;
+  // Maximum in-plane rotation.
+  double max_roll_degrees = 20;
+  // Gaussian blur sigma in pixels, 0 disables.
+  double blur_sigma = 0;
+  // Standard deviation of additive Gaussian noise, 0 disables.
+  double noise_stddev = 0;
+  uint64_t seed = 0;
+};
+
+struct SyntheticFrame {
+  int64_t frame_index = 0;
+  cv::Mat image;
+  cv::Vec3d rvec;
+  cv::Vec3d tvec;
+  // Marker centers in the order of context object points. Marker id is
+  // BoundaryMarkerId of the index.
+  std::vector<cv::Point2f> marker_points;
+  // Four corners per marker in Aruco order.
+  std::vector<std::vector<cv::Point2f>> marker_corners;
+  // Projected item points in the order of context item points.
+  std::vector<cv::Point2f> item_points;
+};
+
+class SyntheticSceneGenerator {
+ public:
+  // Builds the tray texture and the per-pixel undistortion map once.
+  // Context must have at least four planar (z = 0) object points.
+  static absl::StatusOr<SyntheticSceneGenerator> Create(
+      const IntrinsicCalibration& calibration, const Context& context,
+      const SceneOptions& options,
+      const cv::aruco::Dictionary& dictionary =
+          cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250));
+
+  // Renders a frame with a random pose. The pose, noise and therefore the
+  // frame are fully determined by seed and frame_index, so it is safe to
+  // call concurrently.
+  SyntheticFrame Render(int64_t frame_index) const;
+
+  // Renders frames [first_frame_index, first_frame_index + count) in
+  // parallel.
+  std::vector<SyntheticFrame> RenderBatch(int64_t first_frame_index,
+                                          int32_t count) const;
+
+  // Calibration scaled to the output image size.
+  const IntrinsicCalibration& calibration() const { return calibration_; }
+
+ private:
+  SyntheticSceneGenerator() = default;
+
+  IntrinsicCalibration calibration_;
+  Context context_;
+  SceneOptions options_;
+  // Maps context coordinates to tray texture pixels.
+  cv::Matx33d context_to_texture_;
+  cv::Mat texture_;
+  // Undistorted normalized camera coordinates of every output pixel,
+  // CV_32FC2 of the output image size.
+  cv::Mat normalized_map_;
+  cv::Point2f tray_center_;
+  cv::Size2f tray_extent_;
+};
+
+}  // namespace aruco
+
+#endif  // SYNTHETIC_SCENE_H
@@ -0,0 +1,197 @@
+// Generates synthetic frames of the tray with ground truth.
+// bazel run -c opt //project_points:synthetic_scene_main --
+// --output_dir=/tmp/synthetic --num_frames=10000 --noise_stddev=4
+// --blur_sigma=0.8
+#include <filesystem>
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/videoio.hpp"
+#include "project_points/proto/ground_truth.pb.h"
+#include "project_points/proto_utils.h"
+#include "project_points/synthetic_scene.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, calibration_path, "testdata/pixel_6a_calibration.txtpb",
+          "Intrinsic camera calibration");
+
+ABSL_FLAG(std::string, manifest_path, "testdata/simple_manifest.txtpb",
+          "Manifest text proto file");
+
+ABSL_FLAG(std::string, output_dir, "",
+          "Directory for the image sequence. Empty to skip images.");
+
+ABSL_FLAG(std::string, output_video_path, "",
+          "Output video. Empty to skip video.");
+
+ABSL_FLAG(std::string, ground_truth_path, "",
+          "Ground truth text proto. Defaults to ground_truth.txtpb in "
+          "output_dir.");
+
+ABSL_FLAG(int32_t, num_frames, 100, "Number of frames to generate");
+
+ABSL_FLAG(int32_t, batch_size, 64, "Frames rendered in parallel at once");
+
+ABSL_FLAG(int32_t, width, 1920, "Output frame width");
+
+ABSL_FLAG(int32_t, height, 1080, "Output frame height");
+
+ABSL_FLAG(int32_t, calibration_width, 1920,
+          "Frame width the calibration belongs to");
+
+ABSL_FLAG(int32_t, calibration_height, 1080,
+          "Frame height the calibration belongs to");
+
+ABSL_FLAG(double, noise_stddev, 0, "Gaussian noise standard deviation");
+
+ABSL_FLAG(double, blur_sigma, 0, "Gaussian blur sigma in pixels");
+
+ABSL_FLAG(double, fps, 30, "Output video frame rate");
+
+ABSL_FLAG(uint64_t, seed, 0, "Random seed for poses and noise");
+
+aruco::proto::ImagePoint ToProto(const cv::Point2f& point) {
+  aruco::proto::ImagePoint proto;
+  proto.set_x(point.x);
+  proto.set_y(point.y);
+  return proto;
+}
+
+aruco::proto::FrameGroundTruth ToProto(const aruco::SyntheticFrame& frame,
+                                       const aruco::Context& context,
+                                       absl::string_view image_path) {
+  aruco::proto::FrameGroundTruth proto;
+  proto.set_frame_index(frame.frame_index);
+  proto.set_image_path(image_path);
+  for (int32_t i = 0; i < 3; ++i) {
+    proto.mutable_pose()->add_rvec(frame.rvec[i]);
+    proto.mutable_pose()->add_tvec(frame.tvec[i]);
+  }
+  for (size_t i = 0; i < frame.marker_points.size(); ++i) {
+    aruco::proto::MarkerGroundTruth* marker = proto.add_markers();
+    marker->set_id(aruco::BoundaryMarkerId(context, i));
+    *marker->mutable_center() = ToProto(frame.marker_points[i]);
+    for (const cv::Point2f& corner : frame.marker_corners[i]) {
+      *marker->add_corners() = ToProto(corner);
+    }
+  }
+  for (size_t i = 0; i < frame.item_points.size(); ++i) {
+    aruco::proto::ItemGroundTruth* item = proto.add_items();
+    item->set_item_id(context.item_points[i].id);
+    *item->mutable_point() = ToProto(frame.item_points[i]);
+  }
+  return proto;
+}
+
+absl::Status Run() {
+  ASSIGN_OR_RETURN(
+      auto proto,
+      aruco::LoadFromTextProtoFile<aruco::proto::IntrinsicCalibration>(
+          absl::GetFlag(FLAGS_calibration_path)));
+  const aruco::IntrinsicCalibration calibration =
+      aruco::ConvertIntrinsicCalibrationFromProto(proto);
+
+  ASSIGN_OR_RETURN(auto manifest,
+                   aruco::LoadFromTextProtoFile<aruco::proto::Context>(
+                       absl::GetFlag(FLAGS_manifest_path)));
+  const aruco::Context context = aruco::ConvertContextFromProto(manifest);
+
+  aruco::SceneOptions options;
+  options.image_size =
+      cv::Size(absl::GetFlag(FLAGS_width), absl::GetFlag(FLAGS_height));
+  options.calibration_size = cv::Size(absl::GetFlag(FLAGS_calibration_width),
+                                      absl::GetFlag(FLAGS_calibration_height));
+  options.noise_stddev = absl::GetFlag(FLAGS_noise_stddev);
+  options.blur_sigma = absl::GetFlag(FLAGS_blur_sigma);
+  options.seed = absl::GetFlag(FLAGS_seed);
+
+  int64_t start_ticks = cv::getTickCount();
+  ASSIGN_OR_RETURN(
+      const aruco::SyntheticSceneGenerator generator,
+      aruco::SyntheticSceneGenerator::Create(calibration, context, options));
+  LOG(INFO) << absl::StreamFormat(
+      "Setup %.0f ms",
+      (cv::getTickCount() - start_ticks) / cv::getTickFrequency() * 1000.0);
+
+  const std::string output_dir = absl::GetFlag(FLAGS_output_dir);
+  if (!output_dir.empty()) std::filesystem::create_directories(output_dir);
+  std::string ground_truth_path = absl::GetFlag(FLAGS_ground_truth_path);
+  if (ground_truth_path.empty() && !output_dir.empty()) {
+    ground_truth_path =
+        (std::filesystem::path(output_dir) / "ground_truth.txtpb").string();
+  }
+
+  cv::VideoWriter writer;
+  if (!absl::GetFlag(FLAGS_output_video_path).empty()) {
+    const int fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v');
+    if (!writer.open(absl::GetFlag(FLAGS_output_video_path), fourcc,
+                     absl::GetFlag(FLAGS_fps), options.image_size,
+                     /*isColor=*/true)) {
+      return absl::InternalError(
+          absl::StrCat("Failed to open output video ",
+                       absl::GetFlag(FLAGS_output_video_path)));
+    }
+  }
+
+  aruco::proto::SceneGroundTruth ground_truth;
+  ground_truth.set_width(options.image_size.width);
+  ground_truth.set_height(options.image_size.height);
+
+  const int32_t num_frames = absl::GetFlag(FLAGS_num_frames);
+  const int32_t batch_size = std::max(1, absl::GetFlag(FLAGS_batch_size));
+  start_ticks = cv::getTickCount();
+  for (int32_t first = 0; first < num_frames; first += batch_size) {
+    const int32_t count = std::min(batch_size, num_frames - first);
+    const std::vector<aruco::SyntheticFrame> frames =
+        generator.RenderBatch(first, count);
+
+    std::vector<std::string> image_paths(count);
+    if (!output_dir.empty()) {
+      // JPEG encoding costs about as much as rendering, so also in parallel.
+      cv::parallel_for_(cv::Range(0, count), [&](const cv::Range& range) {
+        for (int32_t i = range.start; i < range.end; ++i) {
+          image_paths[i] =
+              (std::filesystem::path(output_dir) /
+               absl::StrFormat("frame_%06d.jpg", frames[i].frame_index))
+                  .string();
+          if (!cv::imwrite(image_paths[i], frames[i].image)) {
+            LOG(ERROR) << "Failed to write " << image_paths[i];
+          }
+        }
+      });
+    }
+    for (int32_t i = 0; i < count; ++i) {
+      if (writer.isOpened()) writer.write(frames[i].image);
+      *ground_truth.add_frames() = ToProto(frames[i], context, image_paths[i]);
+    }
+  }
+  const double total_ms =
+      (cv::getTickCount() - start_ticks) / cv::getTickFrequency() * 1000.0;
+  LOG(INFO) << absl::StreamFormat("Generated %d frames in %.0f ms, %.0f FPS",
+                                  num_frames, total_ms,
+                                  num_frames / (total_ms / 1000.0));
+
+  if (!ground_truth_path.empty()) {
+    RETURN_IF_ERROR(
+        aruco::WriteProtoToTextProto(ground_truth, ground_truth_path).status());
+    LOG(INFO) << "Ground truth: " << ground_truth_path;
+  }
+  return absl::OkStatus();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  gflags::SetCommandLineOption("logtostderr", "1");
+  if (const auto status = Run(); !status.ok()) {
+    LOG(ERROR) << "Failed: " << status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include "project_points/synthetic_scene.h"
+#include "absl/status/status_matchers.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+#include "project_points/proto_utils.h"
+#include "tools/cpp/runfiles/runfiles.h"
+
+namespace aruco {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+using ::bazel::tools::cpp::runfiles::Runfiles;
+
+class SyntheticSceneTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    const Runfiles* files = Runfiles::CreateForTest();
+    auto calibration_proto =
+        LoadFromTextProtoFile<aruco::proto::IntrinsicCalibration>(
+            files->Rlocation("_main/testdata/pixel_6a_calibration.txtpb"));
+    ASSERT_THAT(calibration_proto, IsOk());
+    calibration_ = ConvertIntrinsicCalibrationFromProto(*calibration_proto);
+
+    auto manifest = LoadFromTextProtoFile<aruco::proto::Context>(
+        files->Rlocation("_main/testdata/simple_manifest.txtpb"));
+    ASSERT_THAT(manifest, IsOk());
+    context_ = ConvertContextFromProto(*manifest);
+  }
+
+  IntrinsicCalibration calibration_;
+  Context context_;
+};
+
+TEST_F(SyntheticSceneTest, DetectedMarkersMatchGroundTruth) {
+  auto generator =
+      SyntheticSceneGenerator::Create(calibration_, context_, SceneOptions());
+  ASSERT_THAT(generator, IsOk());
+
+  const SyntheticFrame frame = generator->Render(/*frame_index=*/0);
+  EXPECT_EQ(frame.image.size(), cv::Size(1920, 1080));
+  ASSERT_THAT(frame.marker_points, testing::SizeIs(4));
+  ASSERT_THAT(frame.item_points, testing::SizeIs(1));
+
+  const DetectedMarkers detected = DetectArucoPoints(
+      frame.image, cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250));
+  ASSERT_THAT(detected, testing::SizeIs(4));
+  for (int32_t id = 1; id <= 4; ++id) {
+    ASSERT_TRUE(detected.contains(id));
+    const cv::Point2f want = frame.marker_points[id - 1];
+    EXPECT_LE(cv::norm(detected.at(id).center - want), 4.0) << id;
+  }
+}
+
+TEST_F(SyntheticSceneTest, RenderIsDeterministic) {
+  SceneOptions options;
+  options.image_size = cv::Size(640, 360);
+  options.noise_stddev = 5;
+  options.blur_sigma = 1;
+  auto generator =
+      SyntheticSceneGenerator::Create(calibration_, context_, options);
+  ASSERT_THAT(generator, IsOk());
+
+  const SyntheticFrame frame = generator->Render(/*frame_index=*/7);
+  const std::vector<SyntheticFrame> batch =
+      generator->RenderBatch(/*first_frame_index=*/5, /*count=*/4);
+  ASSERT_THAT(batch, testing::SizeIs(4));
+  EXPECT_EQ(batch[2].frame_index, 7);
+  EXPECT_EQ(cv::norm(frame.image, batch[2].image, cv::NORM_INF), 0);
+  EXPECT_EQ(frame.rvec, batch[2].rvec);
+  EXPECT_EQ(frame.tvec, batch[2].tvec);
+  EXPECT_NE(cv::norm(frame.image, batch[3].image, cv::NORM_INF), 0);
+}
+
+TEST_F(SyntheticSceneTest, RejectsContextWithoutBoundary) {
+  context_.object_points.resize(3);
+  EXPECT_THAT(
+      SyntheticSceneGenerator::Create(calibration_, context_, SceneOptions()),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace aruco
@@ -0,0 +1,208 @@
+#include "project_points/trace.h"
+#include <unistd.h>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+
+namespace aruco {
+namespace trace {
+namespace {
+
+struct Event {
+  const char* name;
+  int64_t begin_ns;
+  int64_t end_ns;
+  int64_t frame;
+};
+
+// Up to 4M events per thread, allocated a chunk at a time.
+constexpr size_t kChunkEvents = 4096;
+constexpr size_t kMaxChunks = 1024;
+
+// Written only by its thread. The flushing thread reads events below size
+// of buffers that recorded in the current session.
+struct ThreadBuffer {
+  int32_t tid = 0;
+  std::atomic<int64_t> session{0};
+  std::array<std::atomic<Event*>, kMaxChunks> chunks{};
+  std::atomic<size_t> size{0};
+  std::atomic<int64_t> dropped{0};
+};
+
+struct Registry {
+  absl::Mutex mutex;
+  // Buffers outlive their threads so short lived workers are not lost.
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers ABSL_GUARDED_BY(mutex);
+  std::unordered_map<int32_t, std::string> thread_names ABSL_GUARDED_BY(mutex);
+  std::string path ABSL_GUARDED_BY(mutex);
+  int64_t start_ns ABSL_GUARDED_BY(mutex) = 0;
+  bool exit_handler_installed ABSL_GUARDED_BY(mutex) = false;
+};
+
+// Incremented by Start. A thread rewinds its buffer on its first event of a
+// new session, reusing the chunks it already allocated.
+std::atomic<int64_t> current_session{0};
+
+Registry& GetRegistry() {
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+ThreadBuffer& LocalBuffer() {
+  thread_local ThreadBuffer* buffer = []() {
+    Registry& registry = GetRegistry();
+    absl::MutexLock lock(&registry.mutex);
+    auto& added =
+        registry.buffers.emplace_back(std::make_unique<ThreadBuffer>());
+    added->tid = static_cast<int32_t>(registry.buffers.size());
+    return added.get();
+  }();
+  return *buffer;
+}
+
+std::string EscapeJson(absl::string_view text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') escaped.push_back('\\');
+    escaped.push_back(c);
+  }
+  return escaped;
+}
+
+void StopAtExit() {
+  if (const absl::Status status = Stop(); !status.ok()) {
+    std::fprintf(stderr, "Failed to write trace: %s\n",
+                 std::string(status.message()).c_str());
+  }
+}
+
+}  // namespace
+
+namespace internal {
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void Record(const char* name, int64_t begin_ns, int64_t end_ns,
+            int64_t frame) {
+  ThreadBuffer& buffer = LocalBuffer();
+  const int64_t session = current_session.load(std::memory_order_acquire);
+  if (buffer.session.load(std::memory_order_relaxed) != session) {
+    buffer.size.store(0, std::memory_order_relaxed);
+    buffer.dropped.store(0, std::memory_order_relaxed);
+    buffer.session.store(session, std::memory_order_release);
+  }
+  const size_t index = buffer.size.load(std::memory_order_relaxed);
+  const size_t chunk = index / kChunkEvents;
+  if (chunk >= kMaxChunks) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Event* events = buffer.chunks[chunk].load(std::memory_order_relaxed);
+  if (events == nullptr) {
+    events = new Event[kChunkEvents];
+    buffer.chunks[chunk].store(events, std::memory_order_relaxed);
+  }
+  events[index % kChunkEvents] =
+      Event{.name = name, .begin_ns = begin_ns, .end_ns = end_ns,
+            .frame = frame};
+  // Publishes the event and the chunk.
+  buffer.size.store(index + 1, std::memory_order_release);
+}
+
+}  // namespace internal
+
+void Start(absl::string_view path) {
+  Registry& registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  registry.path = std::string(path);
+  registry.start_ns = internal::NowNs();
+  current_session.fetch_add(1, std::memory_order_release);
+  if (!registry.exit_handler_installed) {
+    std::atexit(StopAtExit);
+    registry.exit_handler_installed = true;
+  }
+  internal::enabled.store(true, std::memory_order_relaxed);
+}
+
+absl::Status Stop() {
+  if (!internal::enabled.exchange(false)) return absl::OkStatus();
+  Registry& registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  std::ofstream output(registry.path);
+  if (!output) {
+    return absl::InternalError(
+        absl::StrCat("Failed to open trace ", registry.path));
+  }
+
+  const int32_t pid = static_cast<int32_t>(::getpid());
+  output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  output << absl::StrFormat(
+      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+      "\"args\":{\"name\":\"aruco\"}}",
+      pid);
+  for (const auto& [tid, name] : registry.thread_names) {
+    output << absl::StrFormat(
+        ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+        "\"args\":{\"name\":\"%s\"}}",
+        pid, tid, EscapeJson(name));
+  }
+  const int64_t session = current_session.load(std::memory_order_relaxed);
+  int64_t dropped = 0;
+  for (const auto& buffer : registry.buffers) {
+    if (buffer->session.load(std::memory_order_acquire) != session) continue;
+    dropped += buffer->dropped.load(std::memory_order_relaxed);
+    const size_t size = buffer->size.load(std::memory_order_acquire);
+    for (size_t i = 0; i < size; ++i) {
+      const Event& event =
+          buffer->chunks[i / kChunkEvents].load(std::memory_order_relaxed)
+              [i % kChunkEvents];
+      // Events of an earlier session.
+      if (event.begin_ns < registry.start_ns) continue;
+      output << absl::StrFormat(
+          ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+          "\"ts\":%.3f,\"dur\":%.3f",
+          EscapeJson(event.name), pid, buffer->tid,
+          (event.begin_ns - registry.start_ns) / 1e3,
+          (event.end_ns - event.begin_ns) / 1e3);
+      if (event.frame >= 0) {
+        output << absl::StrFormat(",\"args\":{\"frame\":%d}", event.frame);
+      }
+      output << "}";
+    }
+  }
+  output << "\n]}\n";
+  output.close();
+  if (!output) {
+    return absl::InternalError(
+        absl::StrCat("Failed to write trace ", registry.path));
+  }
+  if (dropped > 0) {
+    return absl::ResourceExhaustedError(absl::StrCat(
+        "Trace buffers were full, dropped ", dropped, " events"));
+  }
+  return absl::OkStatus();
+}
+
+void SetThreadName(absl::string_view name) {
+  const int32_t tid = LocalBuffer().tid;
+  Registry& registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  registry.thread_names[tid] = std::string(name);
+}
+
+}  // namespace trace
+}  // namespace aruco
@@ -0,0 +1,77 @@
+// Opt-in timeline tracing in Chrome trace event format. Open the output in
+// chrome://tracing or https://ui.perfetto.dev.
+//
+//   aruco::trace::Start("/tmp/scan.trace.json");
+//   ...
+//   {
+//     aruco::TraceScope scope("detect", frame_index);
+//     ...
+//   }
+//   ...
+//   aruco::trace::Stop();  // Or at exit.
+//
+// Each thread appends complete events to its own buffer, so recording takes
+// no locks. When tracing is off a scope costs one relaxed atomic load.
+#ifndef TRACE_H
+#define TRACE_H
+#include <atomic>
+#include <cstdint>
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+
+namespace aruco {
+namespace trace {
+namespace internal {
+
+inline std::atomic<bool> enabled{false};
+
+int64_t NowNs();
+void Record(const char* name, int64_t begin_ns, int64_t end_ns,
+            int64_t frame);
+
+}  // namespace internal
+
+// Starts recording. Events are written to path by Stop, or at exit if Stop
+// is not called.
+void Start(absl::string_view path);
+
+// Stops recording and writes the trace. No-op if not started.
+absl::Status Stop();
+
+inline bool Enabled() {
+  return internal::enabled.load(std::memory_order_relaxed);
+}
+
+// Names the calling thread in the trace.
+void SetThreadName(absl::string_view name);
+
+}  // namespace trace
+
+// Records the lifetime of the scope as one event. Name must outlive the
+// trace, e.g. a string literal. Frame is attached when not negative.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name, int64_t frame = -1)
+      : name_(name),
+        frame_(frame),
+        begin_ns_(trace::Enabled() ? trace::internal::NowNs() : -1) {}
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+  ~TraceScope() {
+    if (begin_ns_ >= 0) {
+      trace::internal::Record(name_, begin_ns_, trace::internal::NowNs(),
+                              frame_);
+    }
+  }
+
+ private:
+  const char* name_;
+  int64_t frame_;
+  int64_t begin_ns_;
+};
+
+}  // namespace aruco
+
+#endif  // TRACE_H
@@ -0,0 +1,102 @@
+#include "project_points/trace.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "absl/status/status_matchers.h"
+#include "absl/strings/match.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+
+namespace aruco {
+namespace {
+
+using ::absl_testing::IsOk;
+
+std::string TempPath(absl::string_view name) {
+  return (std::filesystem::path(std::getenv("TEST_TMPDIR")) / name).string();
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream input(path);
+  std::stringstream content;
+  content << input.rdbuf();
+  return content.str();
+}
+
+int32_t CountOf(absl::string_view text, absl::string_view needle) {
+  int32_t count = 0;
+  for (size_t position = text.find(needle); position != text.npos;
+       position = text.find(needle, position + needle.size())) {
+    ++count;
+  }
+  return count;
+}
+
+TEST(Trace, DisabledRecordsNothing) {
+  ASSERT_FALSE(trace::Enabled());
+  { TraceScope scope("before_start"); }
+
+  const std::string path = TempPath("disabled.json");
+  trace::Start(path);
+  ASSERT_THAT(trace::Stop(), IsOk());
+  { TraceScope scope("after_stop"); }
+  EXPECT_THAT(trace::Stop(), IsOk());
+
+  const std::string json = ReadFile(path);
+  EXPECT_TRUE(absl::StartsWith(json, "{")) << json;
+  EXPECT_FALSE(absl::StrContains(json, "before_start"));
+  EXPECT_FALSE(absl::StrContains(json, "after_stop"));
+}
+
+TEST(Trace, RecordsNestedScopesPerThread) {
+  const std::string path = TempPath("threads.json");
+  trace::Start(path);
+  trace::SetThreadName("main");
+  {
+    TraceScope frame("frame", /*frame=*/7);
+    TraceScope detect("detect");
+  }
+  std::thread worker([]() {
+    trace::SetThreadName("worker");
+    for (int32_t i = 0; i < 10000; ++i) TraceScope scope("work", i);
+  });
+  worker.join();
+  ASSERT_THAT(trace::Stop(), IsOk());
+
+  const std::string json = ReadFile(path);
+  EXPECT_TRUE(absl::StrContains(json, "\"traceEvents\""));
+  EXPECT_TRUE(absl::StrContains(json, "\"args\":{\"frame\":7}"));
+  EXPECT_TRUE(absl::StrContains(json, "\"args\":{\"name\":\"worker\"}"));
+  EXPECT_EQ(CountOf(json, "\"name\":\"frame\""), 1);
+  EXPECT_EQ(CountOf(json, "\"name\":\"detect\""), 1);
+  // Events outlive their thread.
+  EXPECT_EQ(CountOf(json, "\"name\":\"work\""), 10000);
+}
+
+TEST(Trace, RestartKeepsOnlyNewEvents) {
+  const std::string first_path = TempPath("first.json");
+  trace::Start(first_path);
+  for (int32_t i = 0; i < 100; ++i) TraceScope scope("first", i);
+  ASSERT_THAT(trace::Stop(), IsOk());
+
+  const std::string second_path = TempPath("second.json");
+  trace::Start(second_path);
+  { TraceScope scope("second"); }
+  ASSERT_THAT(trace::Stop(), IsOk());
+
+  EXPECT_EQ(CountOf(ReadFile(first_path), "\"name\":\"first\""), 100);
+  const std::string json = ReadFile(second_path);
+  EXPECT_FALSE(absl::StrContains(json, "\"name\":\"first\""));
+  EXPECT_EQ(CountOf(json, "\"name\":\"second\""), 1);
+}
+
+TEST(Trace, FailsOnUnwritablePath) {
+  trace::Start(TempPath("missing_dir/trace.json"));
+  EXPECT_FALSE(trace::Stop().ok());
+  EXPECT_FALSE(trace::Enabled());
+}
+
+}  // namespace
+}  // namespace aruco
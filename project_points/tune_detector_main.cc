@@ -0,0 +1,201 @@
+// Finds the fastest detector parameters that still detect every labeled
+// marker and writes them as a DetectorParams text proto for
+// --detector_params_path.
+// bazel run -c opt //project_points:tune_detector_main --
+// --image_dirs=testdata,testdata/scan_2 --expected_ids=1,2,3,4
+// --output_path=/tmp/detector_params.txtpb
+#include <algorithm>
+#include <filesystem>
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "opencv2/core.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/objdetect/aruco_dictionary.hpp"
+#include "project_points/detector_tuning.h"
+#include "project_points/highgui_utils.h"
+#include "project_points/proto/ground_truth.pb.h"
+#include "project_points/proto_utils.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::vector<std::string>, image_dirs, {},
+          "Directories of images that all show the markers in expected_ids");
+
+ABSL_FLAG(std::vector<std::string>, expected_ids,
+          std::vector<std::string>({"1", "2", "3", "4"}),
+          "Marker ids every image in image_dirs shows");
+
+ABSL_FLAG(std::string, ground_truth_path, "",
+          "SceneGroundTruth text proto from synthetic_scene_main. Its frames "
+          "are labeled with marker ids and centers.");
+
+ABSL_FLAG(double, max_center_error_px, 2.0,
+          "Labeled centers must be detected within this distance");
+
+ABSL_FLAG(int32_t, finalists, 8,
+          "Fastest candidates of the parallel sweep that are timed again "
+          "one at a time");
+
+ABSL_FLAG(int32_t, repetitions, 5,
+          "Finalist detection time per image is the best of this many runs");
+
+ABSL_FLAG(std::string, output_path, "detector_params.txtpb",
+          "Output DetectorParams text proto");
+
+absl::Status AddImageDirs(std::vector<aruco::LabeledImage>& images) {
+  std::vector<int32_t> ids;
+  for (const std::string& id : absl::GetFlag(FLAGS_expected_ids)) {
+    int32_t value;
+    if (!absl::SimpleAtoi(id, &value)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid marker id '", id, "'"));
+    }
+    ids.push_back(value);
+  }
+  for (const std::string& dir : absl::GetFlag(FLAGS_image_dirs)) {
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, error)) {
+      if (aruco::GetFileType(entry.path().string()) ==
+          aruco::FileType::kImage) {
+        paths.push_back(entry.path().string());
+      }
+    }
+    if (error) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Failed to list ", dir, ": ", error.message()));
+    }
+    std::sort(paths.begin(), paths.end());
+    for (const std::string& path : paths) {
+      images.push_back({.path = path,
+                        .image = cv::imread(path, cv::IMREAD_GRAYSCALE),
+                        .ids = ids});
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status AddGroundTruth(std::vector<aruco::LabeledImage>& images) {
+  const std::string ground_truth_path = absl::GetFlag(FLAGS_ground_truth_path);
+  if (ground_truth_path.empty()) return absl::OkStatus();
+  ASSIGN_OR_RETURN(
+      const auto ground_truth,
+      aruco::LoadFromTextProtoFile<aruco::proto::SceneGroundTruth>(
+          ground_truth_path));
+  for (const aruco::proto::FrameGroundTruth& frame : ground_truth.frames()) {
+    if (frame.image_path().empty()) continue;
+    aruco::LabeledImage image{
+        .path = frame.image_path(),
+        .image = cv::imread(frame.image_path(), cv::IMREAD_GRAYSCALE)};
+    for (const aruco::proto::MarkerGroundTruth& marker : frame.markers()) {
+      image.ids.push_back(marker.id());
+      image.centers.emplace_back(marker.center().x(), marker.center().y());
+    }
+    images.push_back(std::move(image));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Run() {
+  std::vector<aruco::LabeledImage> images;
+  RETURN_IF_ERROR(AddImageDirs(images));
+  RETURN_IF_ERROR(AddGroundTruth(images));
+  for (const aruco::LabeledImage& image : images) {
+    if (image.image.empty()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Failed to load image '", image.path, "'"));
+    }
+  }
+  if (images.empty()) {
+    return absl::InvalidArgumentError(
+        "No labeled images, set --image_dirs or --ground_truth_path");
+  }
+
+  const cv::aruco::Dictionary dictionary =
+      cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
+  aruco::TuningOptions options;
+  options.max_center_error_px = absl::GetFlag(FLAGS_max_center_error_px);
+
+  // Baseline with the same single candidate timing as the finalists.
+  aruco::TuningOptions final_options = options;
+  final_options.repetitions = absl::GetFlag(FLAGS_repetitions);
+  final_options.stop_at_first_miss = false;
+  const aruco::CandidateScore baseline =
+      aruco::ScoreCandidate(cv::aruco::DetectorParameters(), dictionary,
+                            images, final_options);
+  LOG(INFO) << absl::StreamFormat(
+      "%d images, OpenCV defaults find %d of %d markers in %.1f ms",
+      images.size(), baseline.found_markers, baseline.expected_markers,
+      baseline.total_ms);
+
+  const std::vector<cv::aruco::DetectorParameters> candidates =
+      aruco::EnumerateCandidates(aruco::DefaultSearchSpace(),
+                                 cv::aruco::DetectorParameters());
+  const int64_t start_ticks = cv::getTickCount();
+  const std::vector<aruco::CandidateScore> scores =
+      aruco::ScoreCandidates(candidates, dictionary, images, options);
+  std::vector<int32_t> order;
+  for (int32_t i = 0; i < static_cast<int32_t>(scores.size()); ++i) {
+    if (scores[i].full_recall()) order.push_back(i);
+  }
+  LOG(INFO) << absl::StreamFormat(
+      "Swept %d candidates in %.1f s on %d threads, %d keep full recall",
+      candidates.size(),
+      (cv::getTickCount() - start_ticks) / cv::getTickFrequency(),
+      cv::getNumThreads(), order.size());
+  if (order.empty()) {
+    return absl::NotFoundError("No candidate detects every labeled marker");
+  }
+  std::sort(order.begin(), order.end(), [&scores](int32_t a, int32_t b) {
+    return scores[a].total_ms < scores[b].total_ms;
+  });
+
+  // Parallel timings are single threaded and share the machine, so the
+  // finalists are timed again one at a time.
+  const int32_t finalists = std::clamp(absl::GetFlag(FLAGS_finalists), 1,
+                                       static_cast<int32_t>(order.size()));
+  int32_t best = -1;
+  double best_ms = 0;
+  for (int32_t i = 0; i < finalists; ++i) {
+    const aruco::CandidateScore score = aruco::ScoreCandidate(
+        candidates[order[i]], dictionary, images, final_options);
+    LOG(INFO) << absl::StreamFormat(
+        "%.1f ms, %d of %d markers: %s", score.total_ms, score.found_markers,
+        score.expected_markers,
+        aruco::DescribeDetectorParameters(candidates[order[i]]));
+    if (score.full_recall() && (best < 0 || score.total_ms < best_ms)) {
+      best = order[i];
+      best_ms = score.total_ms;
+    }
+  }
+  if (best < 0) {
+    return absl::NotFoundError("No finalist kept full recall when re-timed");
+  }
+  LOG(INFO) << absl::StreamFormat(
+      "Fastest: %.1f ms vs %.1f ms with defaults, %.2fx: %s", best_ms,
+      baseline.total_ms, baseline.total_ms / best_ms,
+      aruco::DescribeDetectorParameters(candidates[best]));
+
+  RETURN_IF_ERROR(aruco::WriteProtoToTextProto(
+                      aruco::ConvertDetectorParametersToProto(candidates[best]),
+                      absl::GetFlag(FLAGS_output_path))
+                      .status());
+  LOG(INFO) << "Detector parameters: " << absl::GetFlag(FLAGS_output_path);
+  return absl::OkStatus();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  gflags::SetCommandLineOption("logtostderr", "1");
+  if (const auto status = Run(); !status.ok()) {
+    LOG(ERROR) << "Failed: " << status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
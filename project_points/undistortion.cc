@@ -0,0 +1,116 @@
+#include "project_points/undistortion.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include "absl/strings/str_cat.h"
+#include "opencv2/calib3d.hpp"
+#include "opencv2/imgproc.hpp"
+#include "project_points/trace.h"
+
+namespace aruco {
+
+absl::StatusOr<Undistortion> Undistortion::Create(
+    const IntrinsicCalibration& calibration, cv::Size image_size,
+    const UndistortionOptions& options) {
+  if (calibration.camera_matrix.size() != cv::Size(3, 3)) {
+    return absl::InvalidArgumentError("Camera matrix must be 3x3");
+  }
+  if (image_size.empty()) {
+    return absl::InvalidArgumentError("Image size must not be empty");
+  }
+  // Fixed point maps store source positions as int16.
+  if (image_size.width > SHRT_MAX || image_size.height > SHRT_MAX) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Image size ", image_size.width, "x", image_size.height,
+        " exceeds fixed point maps"));
+  }
+  if (options.alpha < 0 || options.alpha > 1) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Alpha must be in [0, 1], got ", options.alpha));
+  }
+  if (options.band_rows <= 0) {
+    return absl::InvalidArgumentError("Band rows must be positive");
+  }
+
+  Undistortion undistortion;
+  undistortion.calibration_ = calibration;
+  undistortion.image_size_ = image_size;
+  undistortion.options_ = options;
+  undistortion.rectified_calibration_.camera_matrix =
+      cv::getOptimalNewCameraMatrix(calibration.camera_matrix,
+                                    calibration.distortion_params, image_size,
+                                    options.alpha, image_size);
+  undistortion.rectified_calibration_.distortion_params =
+      cv::Mat::zeros(1, 5, CV_64F);
+  cv::initUndistortRectifyMap(
+      calibration.camera_matrix, calibration.distortion_params, cv::Mat(),
+      undistortion.rectified_calibration_.camera_matrix, image_size, CV_16SC2,
+      undistortion.map_xy_, undistortion.map_fraction_);
+  return undistortion;
+}
+
+void Undistortion::Remap(const cv::Mat& frame, cv::Mat& rectified,
+                         const cv::Rect& roi) const {
+  TraceScope scope("rectify");
+  CV_Assert(frame.size() == image_size_);
+  const cv::Rect full(cv::Point(0, 0), image_size_);
+  const cv::Rect area = roi.empty() ? full : roi & full;
+  rectified.create(image_size_, frame.type());
+  if (area != full) rectified.setTo(cv::Scalar::all(0));
+  if (area.empty()) return;
+
+  // Maps hold absolute source positions, so a band of the maps remaps
+  // straight into the same band of the output.
+  const int32_t bands =
+      (area.height + options_.band_rows - 1) / options_.band_rows;
+  cv::parallel_for_(
+      cv::Range(0, bands),
+      [&](const cv::Range& range) {
+        for (int32_t band = range.start; band < range.end; ++band) {
+          const int32_t top = area.y + band * options_.band_rows;
+          const cv::Rect rows(area.x, top, area.width,
+                              std::min(options_.band_rows,
+                                       area.y + area.height - top));
+          cv::Mat output = rectified(rows);
+          cv::remap(frame, output, map_xy_(rows), map_fraction_(rows),
+                    cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        }
+      },
+      /*nstripes=*/bands);
+}
+
+std::vector<cv::Point2f> Undistortion::RectifyPoints(
+    const std::vector<cv::Point2f>& points) const {
+  std::vector<cv::Point2f> rectified;
+  if (points.empty()) return rectified;
+  // More iterations than the default so that strong distortion agrees with
+  // the exact forward model the maps are built from.
+  cv::undistortPoints(
+      points, rectified, calibration_.camera_matrix,
+      calibration_.distortion_params, cv::noArray(),
+      rectified_calibration_.camera_matrix,
+      cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20,
+                       1e-8));
+  return rectified;
+}
+
+cv::Rect Undistortion::RoiAround(
+    const std::vector<cv::Point2f>& rectified_points, int32_t margin) const {
+  if (rectified_points.empty()) return cv::Rect();
+  cv::Point2f min = rectified_points.front();
+  cv::Point2f max = rectified_points.front();
+  for (const cv::Point2f& point : rectified_points) {
+    min.x = std::min(min.x, point.x);
+    min.y = std::min(min.y, point.y);
+    max.x = std::max(max.x, point.x);
+    max.y = std::max(max.y, point.y);
+  }
+  const cv::Rect box(
+      cv::Point(static_cast<int>(std::floor(min.x)) - margin,
+                static_cast<int>(std::floor(min.y)) - margin),
+      cv::Point(static_cast<int>(std::ceil(max.x)) + margin + 1,
+                static_cast<int>(std::ceil(max.y)) + margin + 1));
+  return box & cv::Rect(cv::Point(0, 0), image_size_);
+}
+
+}  // namespace aruco
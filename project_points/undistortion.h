@@ -0,0 +1,66 @@
+// Rectifies frames of a calibrated camera. The undistortion maps are built
+// once as fixed point CV_16SC2 maps, so a frame costs a single remap instead
+// of the map computation cv::undistort repeats on every call.
+#ifndef UNDISTORTION_H
+#define UNDISTORTION_H
+#include <cstdint>
+#include <vector>
+#include "absl/status/statusor.h"
+#include "opencv2/core.hpp"
+#include "project_points/projection.h"
+
+namespace aruco {
+
+struct UndistortionOptions {
+  // Free scaling as in cv::getOptimalNewCameraMatrix. 0 keeps only valid
+  // pixels, 1 keeps every source pixel with black borders.
+  double alpha = 0;
+  // Rows remapped per parallel task.
+  int32_t band_rows = 64;
+};
+
+class Undistortion {
+ public:
+  // Frames must have image_size, the resolution of the calibration.
+  static absl::StatusOr<Undistortion> Create(
+      const IntrinsicCalibration& calibration, cv::Size image_size,
+      const UndistortionOptions& options = UndistortionOptions());
+
+  // Remaps frame into rectified in parallel row bands. With a non empty roi
+  // only pixels inside it are remapped and the rest of rectified is black.
+  // roi is in rectified coordinates and clipped to the image.
+  void Remap(const cv::Mat& frame, cv::Mat& rectified,
+             const cv::Rect& roi = cv::Rect()) const;
+
+  // Maps frame pixels, e.g. detections or projected items, to the rectified
+  // frame.
+  std::vector<cv::Point2f> RectifyPoints(
+      const std::vector<cv::Point2f>& points) const;
+
+  // Box around rectified points grown by margin on every side, clipped to
+  // the image. Empty without points.
+  cv::Rect RoiAround(const std::vector<cv::Point2f>& rectified_points,
+                     int32_t margin) const;
+
+  // Camera of the rectified frames, without distortion.
+  const IntrinsicCalibration& rectified_calibration() const {
+    return rectified_calibration_;
+  }
+  cv::Size image_size() const { return image_size_; }
+
+ private:
+  Undistortion() = default;
+
+  IntrinsicCalibration calibration_;
+  IntrinsicCalibration rectified_calibration_;
+  cv::Size image_size_;
+  UndistortionOptions options_;
+  // CV_16SC2 integer source positions and CV_16UC1 interpolation table
+  // indices of every rectified pixel.
+  cv::Mat map_xy_;
+  cv::Mat map_fraction_;
+};
+
+}  // namespace aruco
+
+#endif  // UNDISTORTION_H
@@ -0,0 +1,147 @@
+#include "project_points/undistortion.h"
+#include "absl/status/status_matchers.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+#include "opencv2/calib3d.hpp"
+#include "opencv2/imgproc.hpp"
+
+namespace aruco {
+namespace {
+
+using ::absl_testing::IsOk;
+using ::absl_testing::StatusIs;
+
+const cv::Size kImageSize(640, 480);
+
+// Strong barrel distortion, as with wide angle phone cameras.
+IntrinsicCalibration Calibration() {
+  return {.camera_matrix =
+              cv::Mat(cv::Matx33d(500, 0, 320, 0, 500, 240, 0, 0, 1)),
+          .distortion_params =
+              cv::Mat(cv::Matx<double, 1, 5>(-0.3, 0.1, 0.001, -0.001, 0))};
+}
+
+// Frame pixel that the rectified pixel samples.
+cv::Point2f SourceOf(const Undistortion& undistortion,
+                     const cv::Point2f& rectified) {
+  const cv::Matx33d new_matrix(
+      undistortion.rectified_calibration().camera_matrix);
+  const cv::Vec3d ray =
+      new_matrix.inv() * cv::Vec3d(rectified.x, rectified.y, 1);
+  const IntrinsicCalibration calibration = Calibration();
+  std::vector<cv::Point2f> source;
+  cv::projectPoints(std::vector<cv::Point3f>{cv::Point3f(ray[0], ray[1], 1)},
+                    cv::Vec3d(), cv::Vec3d(), calibration.camera_matrix,
+                    calibration.distortion_params, source);
+  return source.front();
+}
+
+// Random texture so that any misplaced pixel shows up.
+cv::Mat Texture() {
+  cv::Mat frame(kImageSize, CV_8UC3);
+  cv::RNG rng(7);
+  rng.fill(frame, cv::RNG::UNIFORM, 0, 256);
+  return frame;
+}
+
+TEST(Undistortion, RejectsInvalidInput) {
+  EXPECT_THAT(Undistortion::Create(IntrinsicCalibration(), kImageSize),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Undistortion::Create(Calibration(), cv::Size()),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  UndistortionOptions options;
+  options.band_rows = 0;
+  EXPECT_THAT(Undistortion::Create(Calibration(), kImageSize, options),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(Undistortion, PointsMatchMaps) {
+  auto undistortion = Undistortion::Create(Calibration(), kImageSize);
+  ASSERT_THAT(undistortion, IsOk());
+  const std::vector<cv::Point2f> expected = {
+      {20, 20}, {320, 240}, {600, 40}, {610, 450}, {100, 400}};
+  std::vector<cv::Point2f> sources;
+  for (const cv::Point2f& point : expected) {
+    sources.push_back(SourceOf(*undistortion, point));
+  }
+  const std::vector<cv::Point2f> rectified =
+      undistortion->RectifyPoints(sources);
+  ASSERT_THAT(rectified, testing::SizeIs(expected.size()));
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_LE(cv::norm(rectified[i] - expected[i]), 0.05) << expected[i];
+  }
+}
+
+TEST(Undistortion, RemapMovesFramePixels) {
+  // Keeps every source pixel, so the frame corner moves inwards.
+  UndistortionOptions options;
+  options.alpha = 1;
+  auto undistortion = Undistortion::Create(Calibration(), kImageSize, options);
+  ASSERT_THAT(undistortion, IsOk());
+  const cv::Point2f source(60, 50);
+  cv::Mat frame = cv::Mat::zeros(kImageSize, CV_8UC1);
+  cv::circle(frame, cv::Point(source), 3, cv::Scalar(255), cv::FILLED);
+  cv::Mat rectified;
+  undistortion->Remap(frame, rectified);
+
+  const cv::Moments moments = cv::moments(rectified);
+  ASSERT_GT(moments.m00, 0);
+  const cv::Point2f centroid(moments.m10 / moments.m00,
+                             moments.m01 / moments.m00);
+  const cv::Point2f expected = undistortion->RectifyPoints({source}).front();
+  EXPECT_LE(cv::norm(centroid - expected), 1.0);
+  EXPECT_GT(cv::norm(expected - source), 5.0);
+}
+
+TEST(Undistortion, BandsMatchSingleRemap) {
+  const cv::Mat frame = Texture();
+  auto undistortion = Undistortion::Create(Calibration(), kImageSize);
+  ASSERT_THAT(undistortion, IsOk());
+  const IntrinsicCalibration calibration = Calibration();
+  cv::Mat map_xy, map_fraction;
+  cv::initUndistortRectifyMap(
+      calibration.camera_matrix, calibration.distortion_params, cv::Mat(),
+      undistortion->rectified_calibration().camera_matrix, kImageSize,
+      CV_16SC2, map_xy, map_fraction);
+  cv::Mat expected;
+  cv::remap(frame, expected, map_xy, map_fraction, cv::INTER_LINEAR);
+
+  for (int32_t band_rows : {1, 7, 64, 1000}) {
+    SCOPED_TRACE(band_rows);
+    UndistortionOptions options;
+    options.band_rows = band_rows;
+    auto banded = Undistortion::Create(Calibration(), kImageSize, options);
+    ASSERT_THAT(banded, IsOk());
+    cv::Mat rectified;
+    banded->Remap(frame, rectified);
+    EXPECT_EQ(cv::norm(rectified, expected, cv::NORM_INF), 0);
+  }
+}
+
+TEST(Undistortion, RemapsOnlyRoi) {
+  const cv::Mat frame = Texture();
+  auto undistortion = Undistortion::Create(Calibration(), kImageSize);
+  ASSERT_THAT(undistortion, IsOk());
+  cv::Mat full;
+  undistortion->Remap(frame, full);
+
+  const cv::Rect roi = undistortion->RoiAround({{200, 150}, {420, 330}}, 10);
+  EXPECT_EQ(roi, cv::Rect(190, 140, 241, 201));
+  cv::Mat partial;
+  undistortion->Remap(frame, partial, roi);
+  EXPECT_EQ(cv::norm(partial(roi), full(roi), cv::NORM_INF), 0);
+  cv::Mat outside = partial.clone();
+  outside(roi).setTo(cv::Scalar::all(0));
+  EXPECT_EQ(cv::countNonZero(outside.reshape(1)), 0);
+}
+
+TEST(Undistortion, RoiIsClippedToImage) {
+  auto undistortion = Undistortion::Create(Calibration(), kImageSize);
+  ASSERT_THAT(undistortion, IsOk());
+  EXPECT_EQ(undistortion->RoiAround({{-50, 10}, {700, 20}}, 5),
+            cv::Rect(0, 5, 640, 21));
+  EXPECT_TRUE(undistortion->RoiAround({}, 5).empty());
+}
+
+}  // namespace
+}  // namespace aruco
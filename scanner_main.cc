@@ -1,16 +1,67 @@
+#include <chrono>
+#include <memory>
+#include <optional>
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_format.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "opencv2/core.hpp"
 #include "opencv2/highgui.hpp"
 #include "opencv2/objdetect/aruco_dictionary.hpp"
+#include "project_points/frame_recording.h"
 #include "project_points/highgui_utils.h"
+#include "project_points/latency_controller.h"
+#include "project_points/proto_utils.h"
+#include "project_points/trace.h"
+#include "status_macros.h"
+
+ABSL_FLAG(std::string, record_path, "",
+          "Records raw camera frames with capture timestamps to this file");
+
+ABSL_FLAG(std::string, replay_path, "",
+          "Replays a recording instead of reading the camera");
+
+ABSL_FLAG(bool, replay_as_fast_as_possible, false,
+          "Replays without the original capture cadence");
+
+ABSL_FLAG(double, preview_fps, 15,
+          "Maximum preview rate, independent of the processing rate. 0 shows "
+          "every frame.");
+
+ABSL_FLAG(std::string, detector_params_path, "",
+          "DetectorParams text proto from tune_detector_main. Empty uses the "
+          "OpenCV defaults. With a latency budget it is the full effort "
+          "level, lower levels reduce it.");
+
+ABSL_FLAG(double, latency_budget_ms, 0,
+          "Per-frame processing budget. Detection effort adapts to hold it "
+          "by downscaling, fewer threshold windows, no corner refinement "
+          "and detecting only on keyframes. 0 always uses full effort.");
+
+ABSL_FLAG(std::string, trace_path, "",
+          "Writes a Chrome trace event timeline of every frame stage, for "
+          "chrome://tracing or ui.perfetto.dev");
 
 absl::Status Run() {
-  cv::VideoCapture cap(0);
+  std::unique_ptr<cv::VideoCapture> capture;
+  if (const std::string replay_path = absl::GetFlag(FLAGS_replay_path);
+      !replay_path.empty()) {
+    capture = std::make_unique<aruco::ReplayCapture>(
+        replay_path, absl::GetFlag(FLAGS_replay_as_fast_as_possible)
+                         ? aruco::ReplayCapture::Pacing::kAsFastAsPossible
+                         : aruco::ReplayCapture::Pacing::kOriginal);
+  } else {
+    capture = std::make_unique<cv::VideoCapture>(0);
+  }
+  cv::VideoCapture& cap = *capture;
   if (!cap.isOpened()) {
+    if (const std::string replay_path = absl::GetFlag(FLAGS_replay_path);
+        !replay_path.empty()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Failed to open replay %s", replay_path));
+    }
     return absl::InvalidArgumentError(
         absl::StrFormat("Failed to open camera."));
   }
@@ -26,30 +77,92 @@ absl::Status Run() {
 
   const cv::aruco::Dictionary dictionary =
       cv::aruco::getPredefinedDictionary(cv::aruco::DICT_6X6_250);
-  const auto detectorParams = cv::aruco::DetectorParameters();
-  const cv::aruco::ArucoDetector detector(dictionary, detectorParams);
-  auto detect = [&detector](const cv::Mat& image) {
-    std::vector<int32_t> ids;
-    std::vector<std::vector<cv::Point2f>> corners;
-    detector.detectMarkers(image, corners, ids, cv::noArray());
-    if (!ids.empty()) {
-      cv::aruco::drawDetectedMarkers(image, corners, ids);
-    }
-  };
+  ASSIGN_OR_RETURN(const cv::aruco::DetectorParameters baseParams,
+                   aruco::LoadDetectorParameters(
+                       absl::GetFlag(FLAGS_detector_params_path)));
+  auto detectorParams = baseParams;
+  std::optional<aruco::LatencyController> controller;
+  aruco::DetectionEffort effort;
+  if (const double budget_ms = absl::GetFlag(FLAGS_latency_budget_ms);
+      budget_ms > 0) {
+    controller.emplace(aruco::DefaultEffortLevels(baseParams),
+                       aruco::LatencyControllerOptions{.budget_ms = budget_ms});
+    effort = controller->effort();
+    aruco::ApplyEffort(effort, detectorParams);
+    LOG(INFO) << absl::StreamFormat("Latency budget %.1f ms, starting at %s",
+                                    budget_ms, aruco::DescribeEffort(effort));
+  }
+  cv::aruco::ArucoDetector detector(dictionary, detectorParams);
+  cv::Mat scratch;
+  aruco::PreviewWindow preview("Scanner", absl::GetFlag(FLAGS_preview_fps));
+
+  std::unique_ptr<aruco::FrameRecorder> recorder;
+  if (const std::string record_path = absl::GetFlag(FLAGS_record_path);
+      !record_path.empty()) {
+    ASSIGN_OR_RETURN(recorder, aruco::FrameRecorder::Create(record_path));
+  }
 
   cv::Mat frame;
+  // Last detection, shown again on frames between keyframes.
+  aruco::Overlay overlay;
+  int32_t frames_since_keyframe = 0;
   int32_t frame_count = 0;
   int64_t total_processing_ticks = 0;
-  while (cap.read(frame)) {
+  // Taken before read, which blocks until the camera delivers the frame, so
+  // that recordings keep the capture cadence rather than the read latency.
+  int64_t capture_ns = 0;
+  auto read_frame = [&cap, &frame, &frame_count, &capture_ns]() {
+    aruco::TraceScope scope("read", frame_count);
+    capture_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+                     .count();
+    return cap.read(frame);
+  };
+  while (read_frame()) {
+    aruco::TraceScope frame_scope("frame", frame_count);
+    if (recorder != nullptr) {
+      aruco::TraceScope scope("record");
+      RETURN_IF_ERROR(recorder->Write(frame, capture_ns));
+    }
     ++frame_count;
     const int64_t start_ticks = cv::getTickCount();
-    detect(frame);
-    cv::imshow("Scanner", frame);
+    const bool keyframe = ++frames_since_keyframe >= effort.keyframe_interval;
+    if (keyframe) {
+      overlay.markers =
+          aruco::DetectWithEffort(frame, effort, detector, scratch);
+      if (overlay.markers.dropped() > 0) {
+        LOG(WARNING) << "Dropped " << overlay.markers.dropped()
+                     << " markers beyond " << aruco::DetectedMarkers::kCapacity;
+      }
+      frames_since_keyframe = 0;
+    }
     const int64_t end_ticks = cv::getTickCount();
     total_processing_ticks += (end_ticks - start_ticks);
 
-    if (const int key = cv::waitKey(33) & 0xFF; key == 27)
-      break;  // ESC key only
+    // Frames between keyframes cost next to nothing and would pull the
+    // smoothed time below the budget while every keyframe exceeds it. The
+    // controller spreads keyframe time over the keyframe interval instead.
+    if (controller.has_value() && keyframe) {
+      const double processing_ms =
+          (end_ticks - start_ticks) / cv::getTickFrequency() * 1000.0;
+      if (const auto change = controller->Update(processing_ms);
+          change.has_value()) {
+        effort = controller->effort();
+        detectorParams = baseParams;
+        aruco::ApplyEffort(effort, detectorParams);
+        detector.setDetectorParameters(detectorParams);
+        LOG(INFO) << absl::StreamFormat(
+            "Frame %d: smoothed latency %.1f ms per frame, effort level %d -> "
+            "%d, %s",
+            frame_count, change->smoothed_ms, change->from, change->to,
+            aruco::DescribeEffort(effort));
+      }
+    }
+
+    if (preview.Due()) {
+      if (const int key = preview.Show(frame, overlay) & 0xFF; key == 27)
+        break;  // ESC key only
+    }
   }
 
   const double total_processing_time_ms =
@@ -59,7 +172,22 @@ absl::Status Run() {
   const double mean_ms_per_frame = total_processing_time_ms / frame_count;
   LOG(INFO) << absl::StreamFormat("Mean FPS: %.0f", processing_fps);
   LOG(INFO) << absl::StreamFormat("Mean latency %.0f ms", mean_ms_per_frame);
+  if (controller.has_value()) {
+    const std::vector<aruco::LevelStats> stats = controller->level_stats();
+    for (size_t level = 0; level < stats.size(); ++level) {
+      if (stats[level].frames == 0) continue;
+      LOG(INFO) << absl::StreamFormat(
+          "Effort level %d: %d keyframes, %.1f s, mean %.1f ms (%s)", level,
+          stats[level].frames, stats[level].seconds,
+          stats[level].processing_ms / stats[level].frames,
+          aruco::DescribeEffort(controller->levels()[level]));
+    }
+  }
 
+  if (recorder != nullptr) {
+    RETURN_IF_ERROR(recorder->Close());
+    LOG(INFO) << "Recorded " << recorder->frame_count() << " frames";
+  }
   return absl::OkStatus();
 }
 
@@ -67,7 +195,16 @@ int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   absl::ParseCommandLine(argc, argv);
   gflags::SetCommandLineOption("logtostderr", "1");
-  if (const auto status = Run(); !status.ok()) {
+  if (const std::string trace_path = absl::GetFlag(FLAGS_trace_path);
+      !trace_path.empty()) {
+    aruco::trace::Start(trace_path);
+    aruco::trace::SetThreadName("main");
+  }
+  const auto status = Run();
+  if (const auto trace_status = aruco::trace::Stop(); !trace_status.ok()) {
+    LOG(WARNING) << "Trace: " << trace_status.message();
+  }
+  if (!status.ok()) {
     LOG(ERROR) << "Failed: " << status.message();
     return EXIT_FAILURE;
   }